@@ -28,6 +28,7 @@ LOCAL_SRC_FILES := $(MC_PATH)/main.c \
 		$(MC_PATH)/conf.c \
 		$(MC_PATH)/set_focus.c \
 		$(CMN_PATH)/md5.c \
+		$(CMN_PATH)/lz.c \
 		$(CMN_PATH)/net-unix.c \
 		$(CMN_PATH)/sockbuf.c \
 		$(CMN_PATH)/util.c \
@@ -0,0 +1,691 @@
+/*
+ * File: main-bot.c
+ * Purpose: Headless load generator for multiplayer server benchmarks
+ *
+ * Copyright (c) 2025 MAngband and PWMAngband Developers
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+
+/*
+ * This is the regular client with a "display module" that shows nothing and
+ * types for itself. Each bot is a separate process (the network code keeps a
+ * single connection), forked from this one. A bot logs into its own account
+ * (creating it and a random character the first time), then sends commands
+ * taken in turn from a pattern, and records how long it takes for the server
+ * to answer each of them with the end of a frame update (PKT_END).
+ *
+ * Options (all optional):
+ *   --bots <n>         number of bots (1)
+ *   --name <prefix>    account names are <prefix><number> ("Bot")
+ *   --pass <password>  account password ("botpass")
+ *   --pattern <keys>   w = walk, r = run, z = rest, m = cast, s = shop ("wwwwr")
+ *   --delay <ms>       time between two commands (500)
+ *   --time <seconds>   stop after this long (0 = until interrupted)
+ *   --host <name>, --port <number> as for the client
+ *
+ * Unix only.
+ */
+
+#include "c-angband.h"
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#define BOT_MAX             256     /* Maximum number of bots */
+#define BOT_SPAWN_DELAY     200     /* Delay between two logins (ms) */
+#define BOT_KEY_DELAY       250     /* Delay between two answers at login (ms) */
+#define BOT_STUCK_DELAY     1000    /* Delay before escaping an unknown prompt (ms) */
+#define BOT_SHOP_COOLDOWN   10      /* Random steps after leaving a store */
+#define BOT_HIST_MAX        500     /* Size of the latency histogram (ms) */
+
+
+/*
+ * What a bot reports to the parent when it quits (small enough to be
+ * written atomically to the pipe)
+ */
+struct bot_result
+{
+    uint32_t commands;              /* Commands sent */
+    uint32_t answered;              /* Commands answered */
+    int64_t total;                  /* Total latency (us) */
+    int64_t min;                    /* Lowest latency (us) */
+    int64_t max;                    /* Highest latency (us) */
+    uint32_t hist[BOT_HIST_MAX];    /* Latency histogram (ms) */
+};
+
+
+/*
+ * Prompts shown during login and character creation, and how to answer them
+ */
+struct bot_prompt
+{
+    const char *text;   /* Text to look for on screen */
+    const char *keys;   /* Keys to type */
+    bool enter;         /* Follow with Enter */
+};
+
+
+static char bot_name[NORMAL_WID] = "Bot";
+static char bot_pass[NORMAL_WID] = "botpass";
+static char bot_pattern[NORMAL_WID] = "wwwwr";
+static int32_t bot_delay = 500;
+static int32_t bot_time = 0;
+
+static term bot_term;
+static int bot_pipe = -1;
+static volatile sig_atomic_t bot_stop = 0;
+
+static struct bot_result result;
+static int64_t last_key;
+static int64_t next_action;
+static int64_t stop_at;
+static int64_t sent_at;
+static bool waiting;
+static size_t step;
+static int shop_cooldown;
+static bool shopped;
+static struct loc last_grid;
+
+
+static const struct bot_prompt bot_prompts[] =
+{
+    {"Enter your account's name", bot_name, true},
+    {"Enter your password", bot_pass, true},
+    {"Please select your character traits", "@", false},
+    {"Please select your character", "a", false},
+    {"Enter your player's name", "", true},
+    {"Please select an action", "d", false},
+    {"Quick-start character", "y", false},
+    {"'Ctrl-X' to quit", "", true},
+    {"'ESC' to step back", "", true},
+    {"Press SPACE key to continue", " ", false},
+    {"Start a new game?", "y", false},
+    {"keep trying? [Y/N]", "n", false}
+};
+
+
+/*
+ * Current time in microseconds
+ */
+static int64_t bot_clock(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+
+/*
+ * Check if the screen shows some text
+ */
+static bool bot_screen_has(const char *text)
+{
+    char line[256];
+    int x, y;
+
+    for (y = 0; y < Term->hgt; y++)
+    {
+        for (x = 0; (x < Term->wid) && (x < (int)sizeof(line) - 1); x++)
+        {
+            uint16_t a;
+
+            Term_what(x, y, &a, &line[x]);
+        }
+        line[x] = '\0';
+
+        if (strstr(line, text)) return true;
+    }
+
+    return false;
+}
+
+
+/*
+ * Type a string
+ */
+static void bot_type(const char *keys, bool enter)
+{
+    const char *s;
+
+    for (s = keys; *s; s++) Term_keypress((keycode_t)*s, 0);
+    if (enter) Term_keypress(KC_ENTER, 0);
+}
+
+
+/*
+ * Answer the prompt on screen, if we know it
+ */
+static bool bot_answer(void)
+{
+    size_t i;
+
+    for (i = 0; i < N_ELEMENTS(bot_prompts); i++)
+    {
+        if (!bot_screen_has(bot_prompts[i].text)) continue;
+
+        bot_type(bot_prompts[i].keys, bot_prompts[i].enter);
+        return true;
+    }
+
+    return false;
+}
+
+
+/*
+ * A command has been sent: start the clock
+ */
+static void bot_sent(int64_t now)
+{
+    result.commands++;
+    sent_at = now;
+    waiting = true;
+}
+
+
+/*
+ * End of a frame update: the server answered the last command
+ */
+static void bot_frame_end(void)
+{
+    int64_t lat;
+    int ms;
+
+    if (!waiting) return;
+    waiting = false;
+
+    lat = bot_clock() - sent_at;
+    ms = (int)(lat / 1000);
+
+    if (!result.answered || (lat < result.min)) result.min = lat;
+    if (lat > result.max) result.max = lat;
+    result.answered++;
+    result.total += lat;
+    result.hist[MIN(ms, BOT_HIST_MAX - 1)]++;
+}
+
+
+/*
+ * Walk or run in some direction
+ */
+static void bot_move(cmd_code code, int dir)
+{
+    struct command cmd;
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.code = code;
+    cmd_set_arg_target(&cmd, "direction", dir);
+
+    if (code == CMD_RUN) Send_run(&cmd);
+    else Send_walk(&cmd);
+}
+
+
+/*
+ * Pick a random direction
+ */
+static int bot_random_dir(void)
+{
+    int dir = randint1(8);
+
+    /* Skip "5" */
+    return ((dir >= 5)? dir + 1: dir);
+}
+
+
+/*
+ * Direction to the closest store entrance on screen, or 0 if there is none
+ */
+static int bot_shop_dir(void)
+{
+    int px = COL_MAP + player->grid.x - player->offset_grid.x;
+    int py = ROW_MAP + player->grid.y - player->offset_grid.y;
+    int x, y, best = 0, dx = 0, dy = 0;
+
+    for (y = ROW_MAP; y < Term->hgt - 1; y++)
+    {
+        for (x = COL_MAP; x < Term->wid; x++)
+        {
+            uint16_t a;
+            char c;
+            int d;
+
+            Term_what(x, y, &a, &c);
+            if (!isdigit((unsigned char)c)) continue;
+
+            d = MAX(ABS(x - px), ABS(y - py));
+            if (!d || (best && (d >= best))) continue;
+
+            best = d;
+            dx = x - px;
+            dy = y - py;
+        }
+    }
+
+    if (!best) return 0;
+
+    /* Keypad layout */
+    return 5 + ((dx > 0) - (dx < 0)) - 3 * ((dy > 0) - (dy < 0));
+}
+
+
+/*
+ * Head for the closest store, wandering around when there is none or after
+ * a purchase
+ */
+static void bot_shop_step(void)
+{
+    int dir = 0;
+
+    if (shop_cooldown > 0) shop_cooldown--;
+    else
+    {
+        dir = bot_shop_dir();
+
+        /* Blocked: sidestep */
+        if (dir && loc_eq(&player->grid, &last_grid)) dir = 0;
+    }
+
+    loc_copy(&last_grid, &player->grid);
+    bot_move(CMD_WALK, dir? dir: bot_random_dir());
+}
+
+
+/*
+ * Cast the first spell of the first book we can cast from
+ */
+static bool bot_cast(void)
+{
+    int i;
+
+    for (i = 0; i < z_info->pack_size; i++)
+    {
+        struct object *obj = player->upkeep->inven[i];
+
+        if (!obj || !obj_can_cast_from(player, obj)) continue;
+
+        Send_cast(obj->oidx, 0, DIR_TARGET);
+        return true;
+    }
+
+    return false;
+}
+
+
+/*
+ * Send the next command of the pattern
+ */
+static void bot_action(int64_t now)
+{
+    char action = bot_pattern[step++ % strlen(bot_pattern)];
+
+    switch (action)
+    {
+        case 'r': bot_move(CMD_RUN, bot_random_dir()); break;
+        case 'z': Send_rest(REST_COMPLETE); break;
+        case 's': bot_shop_step(); break;
+        case 'm':
+            if (bot_cast()) break;
+
+            /* Fall through */
+        default: bot_move(CMD_WALK, bot_random_dir()); break;
+    }
+
+    bot_sent(now);
+}
+
+
+/*
+ * Play: send commands from the main prompt, buy something in stores and
+ * escape from anything else
+ */
+static void bot_play(int64_t now)
+{
+    /* Shopping */
+    if (store_ctx)
+    {
+        if (now < next_action) return;
+        next_action = now + bot_delay * 1000;
+
+        /* Buy the first item, then leave */
+        if (!shopped)
+        {
+            Send_store_purchase(0, 1);
+            bot_sent(now);
+            shopped = true;
+        }
+        else
+        {
+            Term_keypress(ESCAPE, 0);
+            shopped = false;
+            shop_cooldown = BOT_SHOP_COOLDOWN;
+        }
+        return;
+    }
+
+    /* Some prompt or popup */
+    if (!inkey_flag || player->screen_save_depth)
+    {
+        if (now - last_key < BOT_STUCK_DELAY * 1000) return;
+
+        if (!bot_answer()) Term_keypress(ESCAPE, 0);
+        last_key = now;
+        return;
+    }
+
+    /* Main prompt (once the server takes commands) */
+    last_key = now;
+    if (!Net_playing() || (now < next_action)) return;
+    next_action = now + bot_delay * 1000;
+
+    bot_action(now);
+}
+
+
+/*
+ * Process events: type whatever the current screen wants
+ */
+static errr Term_xtra_bot_event(int v)
+{
+    int64_t now = bot_clock();
+
+    /* Time is up, or interrupted */
+    if (bot_stop || (stop_at && (now >= stop_at))) quit(NULL);
+
+    /* Don't type ahead */
+    if (Term->key_head == Term->key_tail)
+    {
+        /* Login and character creation */
+        if (!Setup.ready)
+        {
+            if ((now - last_key >= BOT_KEY_DELAY * 1000) && bot_answer()) last_key = now;
+        }
+
+        /* Playing */
+        else bot_play(now);
+    }
+
+    /* Don't spin while waiting */
+    if (v && (Term->key_head == Term->key_tail)) Sleep(10);
+
+    return 0;
+}
+
+
+/*
+ * Handle a "special request"
+ */
+static errr Term_xtra_bot(int n, int v)
+{
+    switch (n)
+    {
+        case TERM_XTRA_EVENT: return Term_xtra_bot_event(v);
+        case TERM_XTRA_DELAY: if (v > 0) Sleep(v); return 0;
+    }
+
+    /* Nothing to display */
+    return 0;
+}
+
+
+static errr Term_curs_bot(int x, int y)
+{
+    return 0;
+}
+
+
+static errr Term_wipe_bot(int x, int y, int n)
+{
+    return 0;
+}
+
+
+static errr Term_text_bot(int x, int y, int n, uint16_t a, const char *s)
+{
+    return 0;
+}
+
+
+static void bot_interrupt(int sig)
+{
+    bot_stop = 1;
+}
+
+
+/*
+ * Display warning message (see "z-util.c")
+ */
+static void hook_plog(const char *str)
+{
+    if (str && str[0]) fprintf(stderr, "%s: %s\n", nick, str);
+}
+
+
+/*
+ * Report to the parent, then clean up
+ */
+static void hook_quit(const char *str)
+{
+    static bool quitting = false;
+
+    /* Don't re-enter if already quitting */
+    if (quitting) return;
+    quitting = true;
+
+    if (str && str[0]) hook_plog(str);
+
+    if (bot_pipe != -1)
+    {
+        if (write(bot_pipe, &result, sizeof(result)) != sizeof(result))
+            fprintf(stderr, "%s: can't report\n", nick);
+        close(bot_pipe);
+        bot_pipe = -1;
+    }
+
+    term_nuke(&bot_term);
+
+    textui_cleanup();
+    cleanup_angband();
+    close_sound();
+
+    /* Cleanup network stuff */
+    Net_cleanup();
+}
+
+
+/*
+ * Prepare the headless "term"
+ */
+static void init_bot(void)
+{
+    term *t = &bot_term;
+
+    term_init(t, NORMAL_WID, NORMAL_HGT, NORMAL_HGT, 256);
+
+    t->text_hook = Term_text_bot;
+    t->wipe_hook = Term_wipe_bot;
+    t->curs_hook = Term_curs_bot;
+    t->xtra_hook = Term_xtra_bot;
+
+    /* Nothing to redraw */
+    t->never_bored = true;
+
+    angband_term[0] = t;
+    Term_activate(t);
+
+    plog_aux = hook_plog;
+    quit_aux = hook_quit;
+}
+
+
+/*
+ * Run one bot
+ */
+static void bot_main(int argc, char **argv, int num)
+{
+    char prefix[NORMAL_WID];
+
+    argv0 = argv[0];
+
+    signal(SIGINT, bot_interrupt);
+    signal(SIGTERM, bot_interrupt);
+
+    memset(&Setup, 0, sizeof(Setup));
+
+    /* Client Config-file */
+    conf_init(NULL);
+
+    /* Setup the file paths */
+    init_stuff();
+
+    init_bot();
+    ANGBAND_SYS = "bot";
+
+    /* Credentials */
+    my_strcpy(prefix, bot_name, sizeof(prefix));
+    strnfmt(bot_name, sizeof(bot_name), "%s%d", prefix, num);
+    my_strcpy(nick, bot_name, sizeof(nick));
+    my_strcpy(pass, bot_pass, sizeof(pass));
+    my_strcpy(real_name, "BOT", sizeof(real_name));
+
+    /* Get the meta address */
+    my_strcpy(meta_address, conf_get_string("MAngband", "meta_address", "mangband.org"),
+        sizeof(meta_address));
+    meta_port = conf_get_int("MAngband", "meta_port", 8802);
+
+    /* Initialize RNG (bots started in the same second must differ) */
+    Rand_quick = false;
+    Rand_state_init((uint32_t)time(NULL) ^ ((uint32_t)getpid() << 8));
+
+    frame_end_hook = bot_frame_end;
+    if (bot_time) stop_at = bot_clock() + (int64_t)bot_time * 1000000;
+
+    /* Initialize everything, contact the server, and start the loop */
+    client_init(true, argc, argv);
+
+    /* Quit */
+    quit(NULL);
+}
+
+
+/*
+ * Collect the bots' reports and print a summary
+ */
+static void bot_report(int fd, int bots)
+{
+    struct bot_result one, all;
+    int64_t pct[3] = {50, 95, 99};
+    int64_t count = 0;
+    int i, ms, reports = 0;
+
+    memset(&all, 0, sizeof(all));
+
+    while (read(fd, &one, sizeof(one)) == sizeof(one))
+    {
+        reports++;
+        all.commands += one.commands;
+        if (one.answered && (!all.answered || (one.min < all.min))) all.min = one.min;
+        all.max = MAX(all.max, one.max);
+        all.answered += one.answered;
+        all.total += one.total;
+        for (ms = 0; ms < BOT_HIST_MAX; ms++) all.hist[ms] += one.hist[ms];
+    }
+
+    printf("%d bots (%d reported), %u commands sent, %u answered\n", bots, reports,
+        all.commands, all.answered);
+    if (!all.answered) return;
+
+    printf("Latency (ms): min %.1f, avg %.1f, max %.1f", all.min / 1000.0,
+        all.total / 1000.0 / all.answered, all.max / 1000.0);
+
+    /* Percentiles, from the histogram */
+    for (i = 0, ms = 0; (i < 3) && (ms < BOT_HIST_MAX); ms++)
+    {
+        count += all.hist[ms];
+        while ((i < 3) && (count * 100 >= pct[i] * all.answered))
+        {
+            printf(", p%d %s%d", (int)pct[i], ((ms == BOT_HIST_MAX - 1)? ">=": "<"),
+                ((ms == BOT_HIST_MAX - 1)? ms: ms + 1));
+            i++;
+        }
+    }
+    printf("\n");
+}
+
+
+/*
+ * Start the bots and wait for them
+ */
+int main(int argc, char *argv[])
+{
+    int32_t bots = 1;
+    int fds[2];
+    int i;
+
+    /* Save command-line arguments */
+    clia_init(argc, (const char**)argv);
+
+    clia_read_int(&bots, "bots");
+    clia_read_string(bot_name, sizeof(bot_name), "name");
+    clia_read_string(bot_pass, sizeof(bot_pass), "pass");
+    clia_read_string(bot_pattern, sizeof(bot_pattern), "pattern");
+    clia_read_int(&bot_delay, "delay");
+    clia_read_int(&bot_time, "time");
+
+    if ((bots < 1) || (bots > BOT_MAX))
+    {
+        fprintf(stderr, "The number of bots must be between 1 and %d.\n", BOT_MAX);
+        return 1;
+    }
+    if (STRZERO(bot_pattern)) my_strcpy(bot_pattern, "w", sizeof(bot_pattern));
+
+    if (pipe(fds) == -1)
+    {
+        perror("pipe");
+        return 1;
+    }
+
+    for (i = 0; i < bots; i++)
+    {
+        pid_t pid = fork();
+
+        if (pid == -1)
+        {
+            perror("fork");
+            break;
+        }
+
+        /* Child */
+        if (!pid)
+        {
+            close(fds[0]);
+            bot_pipe = fds[1];
+            bot_main(argc, argv, i + 1);
+            exit(0);
+        }
+
+        /* Don't log everybody in at once */
+        Sleep(BOT_SPAWN_DELAY);
+    }
+
+    /* Let the bots report before quitting on ^C */
+    signal(SIGINT, SIG_IGN);
+
+    close(fds[1]);
+    bot_report(fds[0], i);
+    close(fds[0]);
+
+    while (wait(NULL) > 0) ;
+
+    return 0;
+}
@@ -70,6 +70,10 @@ int *party_x = NULL;
 int *party_y = NULL;
 
 
+/* Called at the end of each frame update received from the server */
+void (*frame_end_hook)(void) = NULL;
+
+
 /* Similar to server's connp->state */
 static int conn_state;
 
@@ -94,6 +98,11 @@ static uint8_t chardump = 0;
 static int cur_type = 0;
 static int prev_type = 0;
 
+/* Struct info cache */
+static bool struct_cache_on = false;
+static char *struct_info_last = NULL;
+static int struct_info_last_len = 0;
+
 
 /*** Utilities ***/
 
@@ -413,10 +422,269 @@ static int Receive_end(void)
     if ((n = Packet_scanf(&rbuf, "%b", &ch)) <= 0)
         return n;
 
+    if (frame_end_hook) frame_end_hook();
+
+    return 1;
+}
+
+
+/*
+ * Process packets held in a memory buffer as if they had been received.
+ * The buffer must only hold whole packets.
+ */
+static int Net_packet_data(char *data, int len)
+{
+    int n, old_state = conn_state;
+    sockbuf_t saved = rbuf;
+    bool complete;
+
+    memset(&rbuf, 0, sizeof(rbuf));
+    rbuf.sock = -1;
+    rbuf.buf = rbuf.ptr = data;
+    rbuf.size = rbuf.len = len;
+    rbuf.state = SOCKBUF_READ | SOCKBUF_LOCK;
+    n = Net_packet();
+    complete = (rbuf.ptr == rbuf.buf + rbuf.len);
+    rbuf = saved;
+
+    if ((n == -1) || !complete) return -1;
+
+    /* Let Net_packet() pick the new receive methods */
+    if (conn_state != old_state) return -2;
+
+    return 1;
+}
+
+
+/*
+ * A block of setup packets (struct info, text screens) compressed by the
+ * server: unpack it and process the packets it holds.
+ */
+static int Receive_compressed(void)
+{
+    int n;
+    uint8_t ch;
+    uint32_t raw_len, len;
+    char *raw;
+
+    if ((n = Packet_scanf(&rbuf, "%b%lu%lu", &ch, &raw_len, &len)) <= 0)
+        return n;
+
+    /* Paranoia: the server never sends more than a full send buffer */
+    if ((raw_len > SERVER_SEND_SIZE) || (len > (uint32_t)rbuf.size - 9))
+        return -1;
+
+    /* Wait for the whole block */
+    if (rbuf.buf + rbuf.len - rbuf.ptr < (long)len)
+    {
+        Sockbuf_rollback(&rbuf, 9);
+        return 0;
+    }
+
+    raw = mem_alloc(raw_len);
+    if (lz_decompress(rbuf.ptr, len, raw, raw_len) != (int)raw_len)
+    {
+        mem_free(raw);
+        return -1;
+    }
+    rbuf.ptr += len;
+
+    n = Net_packet_data(raw, raw_len);
+    mem_free(raw);
+
+    return n;
+}
+
+
+/*
+ * Check that a digest is made of 32 lowercase hex digits, like the ones from
+ * MD5Digest(), so that it can't point outside of the cache
+ */
+static bool struct_cache_digest_ok(const char *digest)
+{
+    int i;
+
+    for (i = 0; i < MD5_HEX_SIZE - 1; i++)
+    {
+        if (!isdigit((unsigned char)digest[i]) && ((digest[i] < 'a') || (digest[i] > 'f')))
+            return false;
+    }
+
+    return (digest[i] == '\0');
+}
+
+
+/*
+ * Path of a cached struct info block (or of the cache itself if "digest" is
+ * NULL)
+ */
+static void struct_cache_path(char *buf, size_t len, const char *digest)
+{
+    char dir[MSG_LEN];
+
+    path_build(dir, sizeof(dir), ANGBAND_DIR_USER, "cache");
+    if (digest) path_build(buf, len, dir, digest);
+    else my_strcpy(buf, dir, len);
+}
+
+
+/*
+ * Load a cached struct info block, checking that it matches its digest.
+ * Damaged blocks are deleted if "purge" is set.
+ */
+static char *struct_cache_load(const char *digest, int *len, bool purge)
+{
+    char path[MSG_LEN], check[MD5_HEX_SIZE];
+    ang_file *f;
+    char *data;
+
+    if (!struct_cache_digest_ok(digest)) return NULL;
+    struct_cache_path(path, sizeof(path), digest);
+    f = file_open(path, MODE_READ, FTYPE_RAW);
+    if (!f) return NULL;
+
+    data = mem_alloc(SERVER_SEND_SIZE);
+    *len = (int)file_read(f, data, SERVER_SEND_SIZE);
+    file_close(f);
+
+    MD5Digest(data, *len, check);
+    if ((*len <= 2) || (data[0] != PKT_STRUCT_INFO) || !streq(check, digest))
+    {
+        mem_free(data);
+        if (purge) file_delete(path);
+        return NULL;
+    }
+
+    return data;
+}
+
+
+/*
+ * Report the struct info blocks we have cached (checking them on the way)
+ */
+static int Send_struct_cache(void)
+{
+    char path[MSG_LEN], name[MSG_LEN];
+    char digests[STRUCT_CACHE_MAX][MD5_HEX_SIZE];
+    ang_dir *dir;
+    int i, n = 0;
+
+    struct_cache_path(path, sizeof(path), NULL);
+    dir = my_dopen(path);
+    if (dir)
+    {
+        while ((n < STRUCT_CACHE_MAX) && my_dread(dir, name, sizeof(name)))
+        {
+            char *data;
+            int len;
+
+            data = struct_cache_load(name, &len, true);
+            if (!data) continue;
+            mem_free(data);
+            my_strcpy(digests[n++], name, MD5_HEX_SIZE);
+        }
+        my_dclose(dir);
+    }
+
+    if (Packet_printf(&wbuf, "%b%hd", (unsigned)PKT_STRUCT_CACHE, n) <= 0) return -1;
+    for (i = 0; i < n; i++)
+    {
+        if (Packet_printf(&wbuf, "%s", digests[i]) <= 0) return -1;
+    }
+
+    return 1;
+}
+
+
+/*
+ * The server can use our struct info cache
+ */
+static int Receive_struct_cache(void)
+{
+    int n;
+    uint8_t ch;
+
+    if ((n = Packet_scanf(&rbuf, "%b", &ch)) <= 0)
+        return n;
+
+    struct_cache_on = true;
+
+    return 1;
+}
+
+
+/*
+ * The struct info block just received can be cached under this digest
+ */
+static int Receive_struct_digest(void)
+{
+    int n;
+    uint8_t ch;
+    char typ;
+    char digest[NORMAL_WID], check[MD5_HEX_SIZE], path[MSG_LEN];
+    ang_file *f;
+
+    if ((n = Packet_scanf(&rbuf, "%b%c%s", &ch, &typ, digest)) <= 0)
+        return n;
+
+    if (!struct_info_last) return 1;
+
+    /* Only keep what the server meant */
+    MD5Digest(struct_info_last, struct_info_last_len, check);
+    if ((struct_info_last[1] == typ) && streq(check, digest))
+    {
+        struct_cache_path(path, sizeof(path), NULL);
+        if (!dir_exists(path)) dir_create(path);
+        struct_cache_path(path, sizeof(path), digest);
+        f = file_open(path, MODE_WRITE, FTYPE_RAW);
+        if (f)
+        {
+            file_write(f, struct_info_last, struct_info_last_len);
+            file_close(f);
+        }
+    }
+
+    mem_free(struct_info_last);
+    struct_info_last = NULL;
+
     return 1;
 }
 
 
+/*
+ * We have this struct info block already: process our copy
+ */
+static int Receive_struct_cached(void)
+{
+    int n, len;
+    uint8_t ch;
+    char typ;
+    char digest[NORMAL_WID];
+    char *data;
+
+    if ((n = Packet_scanf(&rbuf, "%b%c%s", &ch, &typ, digest)) <= 0)
+        return n;
+
+    /*
+     * The digest comes from the server: never delete anything because of it. Once
+     * we reconnect, the block isn't in the list of cached blocks we report, so the
+     * server sends it in full.
+     */
+    data = struct_cache_load(digest, &len, false);
+    if (!data || (data[1] != typ))
+    {
+        plog("Cached game data is missing or damaged, please reconnect.");
+        mem_free(data);
+        return -1;
+    }
+
+    n = Net_packet_data(data, len);
+    mem_free(data);
+
+    return n;
+}
+
+
 static int Receive_struct_info(void)
 {
     uint8_t ch;
@@ -1567,6 +1835,15 @@ static int Receive_struct_info(void)
         }
     }
 
+    /* Keep a copy in case the server tells us to cache it */
+    if (struct_cache_on)
+    {
+        mem_free(struct_info_last);
+        struct_info_last_len = bytes_read;
+        struct_info_last = mem_alloc(bytes_read);
+        memcpy(struct_info_last, rbuf.ptr - bytes_read, bytes_read);
+    }
+
     return 1;
 }
 
@@ -2250,7 +2527,7 @@ static int rle_decode(sockbuf_t* buf, cave_view_type* lineref, int max_col, int
     for (x = 0; x < max_col; x++)
     {
         /* Read the char/attr pair */
-        nread = Packet_scanf(buf, "%c%hu", &c, &a);
+        nread = Packet_avail(buf, 3);
         if (nread <= 0)
         {
             /* Rollback the socket buffer */
@@ -2259,35 +2536,18 @@ static int rle_decode(sockbuf_t* buf, cave_view_type* lineref, int max_col, int
             /* Packet isn't complete, graceful failure */
             return nread;
         }
+        c = Packet_get_char(buf);
+        a = Packet_get_u16(buf);
         *bytes_read += 3;
 
-        /* RLE_LARGE */
-        if ((mode == RLE_LARGE) && (a & 0x8000))
+        /* RLE_LARGE: bit 0x8000, RLE_CLASSIC: bit 0x40 */
+        if (((mode == RLE_LARGE) && (a & 0x8000)) || ((mode == RLE_CLASSIC) && (a & 0x40)))
         {
             /* First, clear the bit */
-            a &= ~(0x8000);
+            a &= ~((mode == RLE_LARGE)? 0x8000: 0x40);
 
             /* Read the number of repetitions */
-            nread = Packet_scanf(buf, "%hu", &n);
-            if (nread <= 0)
-            {
-                /* Rollback the socket buffer */
-                Sockbuf_rollback(buf, *bytes_read);
-
-                /* Packet isn't complete, graceful failure */
-                return nread;
-            }
-            *bytes_read += 2;
-        }
-
-        /* RLE_CLASSIC */
-        else if ((mode == RLE_CLASSIC) && (a & 0x40))
-        {
-            /* First, clear the bit */
-            a &= ~(0x40);
-
-            /* Read the number of repetitions */
-            nread = Packet_scanf(buf, "%hu", &n);
+            nread = Packet_avail(buf, 2);
             if (nread <= 0)
             {
                 /* Rollback the socket buffer */
@@ -2296,6 +2556,7 @@ static int rle_decode(sockbuf_t* buf, cave_view_type* lineref, int max_col, int
                 /* Packet isn't complete, graceful failure */
                 return nread;
             }
+            n = Packet_get_u16(buf);
             *bytes_read += 2;
         }
 
@@ -2391,6 +2652,42 @@ static void Term_big_queue_char_safe(int x, int y, uint16_t a, char c, uint16_t
 }
 
 
+/*
+ * Draw the grids [from, to) of a line of the main terminal
+ *
+ * "y" is the screen row, "xoff" the first visible grid when part of the line is icky.
+ */
+static void draw_map_grids(uint8_t ch, int y, cave_view_type *dest, cave_view_type *trn,
+    int16_t xoff, int from, int to)
+{
+    int i, x;
+    cave_view_type *scr_info, *trn_info;
+
+    for (i = from; i < to; i++)
+    {
+        /* Index */
+        x = i + xoff;
+        scr_info = dest + x;
+        trn_info = trn + x;
+
+        /* Location */
+        x += COL_MAP;
+        if (ch != PKT_MINI_MAP) x += i * (tile_width - 1);
+
+        /* Draw the character */
+        Term_queue_char_safe(x, y, scr_info->a, scr_info->c, trn_info->a, trn_info->c);
+
+        if ((ch != PKT_MINI_MAP) && (tile_width * tile_height > 1))
+        {
+            uint16_t a_dummy = (use_graphics? COLOUR_WHITE: 0);
+            char c_dummy = (use_graphics? ' ': 0);
+
+            Term_big_queue_char_safe(x, y, scr_info->a, scr_info->c, a_dummy, c_dummy);
+        }
+    }
+}
+
+
 #define DUNGEON_RLE_MODE() (use_graphics? RLE_LARGE: RLE_CLASSIC)
 static int Receive_line_info(void)
 {
@@ -2496,9 +2793,6 @@ static int Receive_line_info(void)
         /* Use MAIN terminal */
         else
         {
-            int i, x;
-            cave_view_type *scr_info, *trn_info;
-
             if (ch == PKT_MINI_MAP) Term->minimap_active = true;
 
             /* For mini-map, be sure the display gets cleared */
@@ -2507,32 +2801,99 @@ static int Receive_line_info(void)
             /* For main map, apply vertical offset */
             else y = (y - 1) * tile_height + 1;
 
-            /* Draw a character n times */
-            for (i = 0; i < cols + coff; i++)
-            {
-                /* Index */
-                x = i + xoff;
-                scr_info = dest + x;
-                trn_info = trn + x;
+            draw_map_grids(ch, y, dest, trn, xoff, 0, cols + coff);
+        }
+    }
 
-                /* Location */
-                x += COL_MAP;
-                if (ch != PKT_MINI_MAP) x += i * (tile_width - 1);
+    return 1;
+}
 
-                /* Draw the character */
-                Term_queue_char_safe(x, y, scr_info->a, scr_info->c, trn_info->a, trn_info->c);
 
-                if ((ch != PKT_MINI_MAP) && (tile_width * tile_height > 1))
-                {
-                    uint16_t a_dummy = (use_graphics? COLOUR_WHITE: 0);
-                    char c_dummy = (use_graphics? ' ': 0);
+/*
+ * Receive the parts of a line of the main map that changed since the server
+ * last sent it (see "Send_line_delta" on the server).
+ */
+static int Receive_line_delta(void)
+{
+    uint8_t ch;
+    int16_t y = 0, cols, spans, x, len;
+    int16_t xoff = 0, coff = 0;
+    int n, i, k, left, right, bytes_read;
+    bool draw;
 
-                    Term_big_queue_char_safe(x, y, scr_info->a, scr_info->c, a_dummy, c_dummy);
-                }
+    if ((n = Packet_scanf(&rbuf, "%b%hd%hd%hd", &ch, &y, &cols, &spans)) <= 0) return n;
+    bytes_read = 7;
+
+    /* Check the max line count */
+    last_line_info = y;
+
+    /* The server only sends these for the main terminal */
+    if (player->remote_term != NTERM_WIN_OVERHEAD) draw = false;
+    else
+    {
+        draw = !player->screen_save_depth;
+
+        /* Shopping */
+        if (store_ctx) draw = false;
+
+        /* Hang on! Icky section! */
+        if (section_icky_row && (y < section_icky_row))
+        {
+            if (section_icky_col > 0) xoff = section_icky_col;
+            if (section_icky_col < 0) coff = section_icky_col;
+            if ((xoff >= cols) || (cols - coff <= 0)) draw = false;
+        }
+    }
+
+    /* Decode the spans */
+    left = cols;
+    right = 0;
+    for (i = 0; i < spans; i++)
+    {
+        if ((n = Packet_scanf(&rbuf, "%hd%hd", &x, &len)) <= 0)
+        {
+            /* Rollback the socket buffer */
+            Sockbuf_rollback(&rbuf, bytes_read);
+
+            /* Packet isn't complete, graceful failure */
+            return n;
+        }
+        bytes_read += 4;
+
+        /* Decode the secondary attr/char stream */
+        if (use_graphics)
+        {
+            n = rle_decode(&rbuf, player->trn_info[y] + x, len, RLE_LARGE, &bytes_read);
+            if (n <= 0) return n;
+        }
+        else
+        {
+            for (k = x; k < x + len; k++)
+            {
+                player->trn_info[y][k].c = 0;
+                player->trn_info[y][k].a = 0;
             }
         }
+
+        /* Decode the attr/char stream */
+        n = rle_decode(&rbuf, player->scr_info[y] + x, len, DUNGEON_RLE_MODE(), &bytes_read);
+        if (n <= 0) return n;
+
+        if (x < left) left = x;
+        if (x + len > right) right = x + len;
     }
 
+    /* Request a redraw if the line was icky */
+    if (!draw)
+    {
+        request_redraw = true;
+        return 1;
+    }
+
+    /* Put data to screen: everything between the first and last change */
+    draw_map_grids(ch, (y - 1) * tile_height + 1, player->scr_info[y], player->trn_info[y], xoff,
+        MAX(left - xoff, 0), MIN(right - xoff, cols + coff));
+
     return 1;
 }
 
@@ -4637,6 +4998,9 @@ static int Receive_play_setup(void)
     if ((n = Packet_scanf(&rbuf, "%b%b", &ch, &chardump)) <= 0)
         return n;
 
+    /* Tell the server which struct info we have cached */
+    if (struct_cache_on) Send_struct_cache();
+
     Send_play(1);
 
     return 1;
@@ -6674,6 +7038,9 @@ int Net_init(int fd)
         return -1;
     }
 
+    /* The server tells us if it can use our struct info cache */
+    struct_cache_on = false;
+
     /* Initialized */
     initialized = 1;
 
@@ -6747,6 +7114,15 @@ int Net_fd(void)
 }
 
 
+/*
+ * Check if the server takes game commands from us yet
+ */
+bool Net_playing(void)
+{
+    return (conn_state == CONN_PLAYING);
+}
+
+
 /*
  * Read packets from the net until there are no more available.
  */
@@ -16,6 +16,7 @@ extern int cursor_y;
 extern int party_n;
 extern int *party_x;
 extern int *party_y;
+extern void (*frame_end_hook)(void);
 
 /*** Utilities ***/
 extern int Flush_queue(void);
@@ -128,6 +129,7 @@ extern int Net_init(int fd);
 extern void Net_cleanup(void);
 extern int Net_flush(void);
 extern int Net_fd(void);
+extern bool Net_playing(void);
 extern int Net_input(void);
 extern bool Net_Send(int Socket, sockbuf_t* ibuf);
 extern bool Net_WaitReply(int Socket, sockbuf_t* ibuf, int retries);
@@ -41,6 +41,7 @@
 #include "datafile.h"
 #include "guid.h"
 #include "md5.h"
+#include "lz.h"
 #include "source.h"
 #include "parser.h"
 #include "obj-common.h"
@@ -44,7 +44,7 @@ bool beta_version(void)
 #define VERSION_MINOR   6
 #define VERSION_PATCH   2
 #define VERSION_EXTRA   1
-#define VERSION_TANGARIA   34
+#define VERSION_TANGARIA   37
 
 
 // Note that it's uint16_t, so max version after << operations might be 65535..
@@ -164,3 +164,9 @@ PKT(CHANNEL, undefined, channel, undefined, channel)
 PKT(HISTORY, undefined, history, undefined, history)
 PKT(AUTOINSCR, autoinscriptions, undefined, undefined, autoinscriptions)
 PKT(PLAY_SETUP, undefined, undefined, play_setup, undefined)
+/* Packets added last so that older packets keep their numbers */
+PKT(LINE_DELTA, undefined, undefined, undefined, line_delta)
+PKT(COMPRESSED, undefined, undefined, compressed, undefined)
+PKT(STRUCT_CACHE, struct_cache, undefined, struct_cache, undefined)
+PKT(STRUCT_DIGEST, undefined, undefined, struct_digest, undefined)
+PKT(STRUCT_CACHED, undefined, undefined, struct_cached, undefined)
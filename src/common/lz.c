@@ -0,0 +1,203 @@
+/*
+ * File: lz.c
+ * Purpose: Small LZ77 codec for network payloads
+ *
+ * Copyright (c) 2025 MAngband and PWMAngband Developers
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+
+
+#include "angband.h"
+
+
+/*
+ * The stream is a list of sequences. Each sequence is:
+ *
+ * - a token byte: number of literals (high nibble), match length minus
+ *   LZ_MIN_MATCH (low nibble); 15 means more length bytes follow (255 means
+ *   add 255 and keep reading)
+ * - the literals
+ * - a 16-bit big-endian offset back into the output, then the extra match
+ *   length bytes
+ *
+ * The last sequence has literals only and ends the stream.
+ */
+#define LZ_MIN_MATCH    4
+#define LZ_MAX_OFFSET   65535
+#define LZ_HASH_BITS    12
+#define LZ_HASH_SIZE    (1 << LZ_HASH_BITS)
+
+
+static uint32_t lz_read32(const char *p)
+{
+    return ((uint32_t)(uint8_t)p[0] | ((uint32_t)(uint8_t)p[1] << 8) |
+        ((uint32_t)(uint8_t)p[2] << 16) | ((uint32_t)(uint8_t)p[3] << 24));
+}
+
+
+static int lz_hash(const char *p)
+{
+    return (int)((lz_read32(p) * 2654435761U) >> (32 - LZ_HASH_BITS));
+}
+
+
+/*
+ * Write a length which doesn't fit in its nibble
+ */
+static char *lz_put_length(char *dest, int len)
+{
+    while (len >= 255)
+    {
+        *dest++ = (char)255;
+        len -= 255;
+    }
+    *dest++ = (char)len;
+    return dest;
+}
+
+
+/*
+ * Write one sequence (no match if "match" is 0)
+ */
+static char *lz_put_sequence(char *dest, const char *lit, int lit_len, int offset, int match)
+{
+    char *token = dest++;
+    int ml = (match? match - LZ_MIN_MATCH: 0);
+
+    *token = (char)(((lit_len < 15)? lit_len: 15) << 4);
+    if (lit_len >= 15) dest = lz_put_length(dest, lit_len - 15);
+    memcpy(dest, lit, lit_len);
+    dest += lit_len;
+
+    if (!match) return dest;
+
+    *token |= (char)((ml < 15)? ml: 15);
+    *dest++ = (char)(offset >> 8);
+    *dest++ = (char)offset;
+    if (ml >= 15) dest = lz_put_length(dest, ml - 15);
+    return dest;
+}
+
+
+/*
+ * Compress "len" bytes from "src" into "dest".
+ *
+ * Returns the compressed size, or -1 if it would be more than "max" bytes
+ * (LZ_BOUND(len) is always enough).
+ */
+int lz_compress(const char *src, int len, char *dest, int max)
+{
+    int *table;
+    int pos = 0, anchor = 0;
+    char *out = dest;
+
+    if (max < LZ_BOUND(len)) return -1;
+
+    table = mem_alloc(LZ_HASH_SIZE * sizeof(int));
+    memset(table, 0xFF, LZ_HASH_SIZE * sizeof(int));
+
+    while (pos + LZ_MIN_MATCH <= len)
+    {
+        int h = lz_hash(src + pos);
+        int ref = table[h];
+        int match = 0;
+
+        table[h] = pos;
+
+        /* Look for a match at the last position with the same hash */
+        if ((ref >= 0) && (pos - ref <= LZ_MAX_OFFSET) &&
+            (lz_read32(src + ref) == lz_read32(src + pos)))
+        {
+            match = LZ_MIN_MATCH;
+            while ((pos + match < len) && (src[ref + match] == src[pos + match])) match++;
+        }
+
+        if (!match)
+        {
+            pos++;
+            continue;
+        }
+
+        out = lz_put_sequence(out, src + anchor, pos - anchor, pos - ref, match);
+        pos += match;
+        anchor = pos;
+    }
+
+    /* Trailing literals */
+    out = lz_put_sequence(out, src + anchor, len - anchor, 0, 0);
+
+    mem_free(table);
+    return out - dest;
+}
+
+
+/*
+ * Read a length which doesn't fit in its nibble
+ */
+static bool lz_get_length(const char **src, const char *end, int *len)
+{
+    uint8_t b;
+
+    do
+    {
+        if (*src >= end) return false;
+        b = (uint8_t)*(*src)++;
+        *len += b;
+    }
+    while (b == 255);
+
+    return true;
+}
+
+
+/*
+ * Decompress "len" bytes from "src" into "dest".
+ *
+ * Returns the decompressed size, or -1 if the stream is corrupt or would
+ * decompress to more than "max" bytes.
+ */
+int lz_decompress(const char *src, int len, char *dest, int max)
+{
+    const char *end = src + len;
+    char *out = dest, *out_end = dest + max;
+
+    while (src < end)
+    {
+        uint8_t token = (uint8_t)*src++;
+        int lit_len = token >> 4, match = token & 0x0F, offset;
+        const char *ref;
+
+        /* Literals */
+        if ((lit_len == 15) && !lz_get_length(&src, end, &lit_len)) return -1;
+        if ((end - src < lit_len) || (out_end - out < lit_len)) return -1;
+        memcpy(out, src, lit_len);
+        src += lit_len;
+        out += lit_len;
+
+        /* Last sequence */
+        if (src == end) break;
+
+        /* Match */
+        if (end - src < 2) return -1;
+        offset = (((uint8_t)src[0]) << 8) | (uint8_t)src[1];
+        src += 2;
+        if ((match == 15) && !lz_get_length(&src, end, &match)) return -1;
+        match += LZ_MIN_MATCH;
+        if ((offset == 0) || (offset > out - dest) || (out_end - out < match)) return -1;
+
+        /* Byte by byte: the match may overlap what it produces */
+        for (ref = out - offset; match > 0; match--) *out++ = *ref++;
+    }
+
+    return out - dest;
+}
@@ -0,0 +1,15 @@
+/*
+ * File: lz.h
+ * Purpose: Small LZ77 codec for network payloads
+ */
+
+#ifndef INCLUDED_LZ_H
+#define INCLUDED_LZ_H
+
+/* Largest compressed size of "N" bytes (incompressible data grows a little) */
+#define LZ_BOUND(N) ((N) + (N) / 255 + 16)
+
+extern int lz_compress(const char *src, int len, char *dest, int max);
+extern int lz_decompress(const char *src, int len, char *dest, int max);
+
+#endif
@@ -353,3 +353,20 @@ void MD5Password(char *string)
     *dst = 0;
     my_strcpy(string, temp, strlen(temp) + 1);
 }
+
+
+/*
+ * Digest of a block of data, as MD5_HEX_SIZE chars of lowercase hex
+ */
+void MD5Digest(const char *buf, int len, char *hex)
+{
+    MD5_CTX context;
+    unsigned char digest[NORMAL_WID];
+    int i;
+
+    MD5Init(&context);
+    MD5Update(&context, (unsigned char*)buf, (unsigned int)len);
+    MD5Final(digest, &context);
+
+    for (i = 0; i < 16; i++) strnfmt(hex + i * 2, 3, "%02x", (unsigned)digest[i]);
+}
@@ -13,6 +13,10 @@
 #define MAX_NAME_LEN    15
 #define MAX_PASS_LEN    40
 
+/* Size of a digest in hex, with its terminating nul */
+#define MD5_HEX_SIZE    33
+
 extern void MD5Password(char *string);
+extern void MD5Digest(const char *buf, int len, char *hex);
 
 #endif
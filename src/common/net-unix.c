@@ -62,6 +62,7 @@ static char sourceid[] =
 #include <sys/time.h>
 #endif
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
@@ -2125,6 +2126,64 @@ int	size;
     return retval;
 } /* DgramWrite */
 
+
+/*
+ *******************************************************************************
+ *
+ *	DgramWritev()
+ *
+ *******************************************************************************
+ * Description
+ *	Sends several buffers on a connected socket with a single system call.
+ *
+ * Input Parameters
+ *	fd		- The socket descriptor.
+ *	bufs		- Pointers to the message buffers.
+ *	sizes		- Sizes of the message buffers.
+ *	count		- Number of buffers (at most DGRAM_IOV_MAX are sent).
+ *
+ * Output Parameters
+ *	None
+ *
+ * Return Value
+ *	The number of bytes sent or -1 if any errors occured.
+ *
+ * Globals Referenced
+ *	None
+ *
+ * External Calls
+ *	writev()
+ *
+ * Called By
+ *	User applications
+ */
+int
+#ifdef __STDC__
+DgramWritev(int fd, char **bufs, int *sizes, int count)
+#else
+DgramWritev(fd, bufs, sizes, count)
+int	fd;
+char	**bufs;
+int	*sizes;
+int	count;
+#endif /* __STDC__ */
+{
+    struct iovec	iov[DGRAM_IOV_MAX];
+    int			i, retval;
+
+    if (count > DGRAM_IOV_MAX) count = DGRAM_IOV_MAX;
+    for (i = 0; i < count; i++)
+    {
+	iov[i].iov_base = bufs[i];
+	iov[i].iov_len = sizes[i];
+    }
+
+    cmw_priv_assert_netaccess();
+    retval = writev(fd, iov, count);
+    cmw_priv_deassert_netaccess();
+    return retval;
+} /* DgramWritev */
+
 
 /*
  *******************************************************************************
@@ -19,6 +19,9 @@
 #define SL_ENORESP		9	/* No response */
 #define SL_ERECEIVE		10	/* Receive error */
 
+/* Most buffers DgramWritev() sends at once */
+#define DGRAM_IOV_MAX		16
+
 #ifndef _SOCKLIB_LIBSOURCE
 #ifdef VMS
 #include <in.h>			/* for sockaddr_in */
@@ -85,6 +88,7 @@ extern int	DgramReceive(int, char *, char *, int);
 extern int	DgramReply(int, char *, int);
 extern int	DgramRead(int fd, char *rbuf, int size);
 extern int	DgramWrite(int fd, char *wbuf, int size);
+extern int	DgramWritev(int fd, char **bufs, int *sizes, int count);
 extern int	DgramSendRec(int, char *, int, char *, int, char *, int);
 extern char	*DgramLastaddr(void);
 extern char	*DgramLastname(void);
@@ -122,6 +126,7 @@ extern int	DgramReceive();
 extern int	DgramReply();
 extern int	DgramRead();
 extern int	DgramWrite();
+extern int	DgramWritev();
 extern int	DgramSendRec();
 extern char	*DgramLastaddr();
 extern char	*DgramLastname();
@@ -1162,6 +1162,61 @@ DgramWrite(int fd, char *wbuf, int size)
 } /* DgramWrite */
 
 
+/*
+ *******************************************************************************
+ *
+ *  DgramWritev()
+ *
+ *******************************************************************************
+ * Description
+ *  Sends several buffers on a connected socket with a single system call.
+ *
+ * Input Parameters
+ *  fd      - The socket descriptor.
+ *  bufs        - Pointers to the message buffers.
+ *  sizes       - Sizes of the message buffers.
+ *  count       - Number of buffers (at most DGRAM_IOV_MAX are sent).
+ *
+ * Output Parameters
+ *  None
+ *
+ * Return Value
+ *  The number of bytes sent or -1 if any errors occured.
+ *
+ * Globals Referenced
+ *  errno   for returning an error value
+ *
+ * External Calls
+ *  WSASend()
+ *
+ * Called By
+ *  User applications
+ */
+int
+DgramWritev(int fd, char **bufs, int *sizes, int count)
+{
+    WSABUF wsabuf[DGRAM_IOV_MAX];
+    DWORD sent = 0;
+    int i;
+
+    if (count > DGRAM_IOV_MAX) count = DGRAM_IOV_MAX;
+    for (i = 0; i < count; i++)
+    {
+        wsabuf[i].buf = bufs[i];
+        wsabuf[i].len = sizes[i];
+    }
+
+    /* If necessary, set errno */
+    if (WSASend(fd, wsabuf, count, &sent, 0, NULL, NULL) == SOCKET_ERROR)
+    {
+        errno = WSAGetLastError();
+        return -1;
+    }
+
+    return (int)sent;
+} /* DgramWritev */
+
+
 /*
  *******************************************************************************
  *
@@ -19,6 +19,9 @@
 #define SL_ENORESP      9   /* No response */
 #define SL_ERECEIVE     10  /* Receive error */
 
+/* Most buffers DgramWritev() sends at once */
+#define DGRAM_IOV_MAX   16
+
 #include <winsock2.h>    /* includes netinet/in.h's sockaddr_in */
 
 extern void SetTimeout(int, int);
@@ -35,6 +38,7 @@ extern int  DgramReceiveAny(int, char *, int);
 extern int  DgramReply(int, char *, int);
 extern int  DgramRead(int fd, char *rbuf, int size);
 extern int  DgramWrite(int fd, char *wbuf, int size);
+extern int  DgramWritev(int fd, char **bufs, int *sizes, int count);
 extern char *DgramLastname(void);
 extern void DgramClose(int);
 extern void GetLocalHostName(char *, unsigned);
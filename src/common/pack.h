@@ -61,6 +61,10 @@ enum
 #define STRUCT_INFO_TRAP    13
 #define STRUCT_INFO_TIMED   14
 #define STRUCT_INFO_PROPS   15
+#define STRUCT_INFO_MAX     16
+
+/* Most struct info digests a client can report as cached */
+#define STRUCT_CACHE_MAX    64
 
 /*
  * PKT_TERM helpers
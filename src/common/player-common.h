@@ -519,6 +519,7 @@ struct player_upkeep
     bool skip_redraw_equip;         /* Skip redraw_equip object */
     struct object *redraw_inven;    /* Single inventory object to redraw */
     bool skip_redraw_inven;         /* Skip redraw_inven object */
+    bool dirty;                     /* Changed since the last save */
 };
 
 /*
@@ -583,10 +584,15 @@ struct player_cave
     uint16_t feeling_squares;   /* How many feeling squares the player has visited */
     int height;
     int width;
-    struct player_square **squares;
+    struct player_square *squares;  /* height * width squares, row by row */
     struct heatmap noise;
     struct heatmap scent;
     bool allocated;
+    struct loc view_begin;      /* Area scanned by the last view update (end excluded) */
+    struct loc view_end;
+    void *block;                /* Storage for the squares, heatmaps and info flags */
+    int capacity;               /* Number of squares the storage can hold */
+    int rows;                   /* Number of heatmap rows allocated */
 };
 
 /*
@@ -760,6 +766,7 @@ struct player
     struct source cursor_who;                       /* Who's tracked by cursor */
     uint8_t special_file_type;                      /* Type of info browsed by this player */
     bitflag (*mflag)[MFLAG_SIZE];                   /* Temporary monster flags */
+    int16_t threats_in_view;                        /* Number of monsters flagged MFLAG_THREAT */
     uint8_t *mon_det;                               /* Were these monsters detected by this player? */
     bitflag pflag[MAX_PLAYERS][MFLAG_SIZE];         /* Temporary monster flags (players) */
     uint8_t play_det[MAX_PLAYERS];                  /* Were these players detected by this player? */
@@ -816,11 +823,18 @@ struct player
     int16_t last_info_line;
     uint8_t remote_term;
     bool bubble_checked;                    /* Have we been included in a time bubble check? */
+    uint32_t bubble_epoch;                  /* Time bubble epoch of the cached time factor */
+    int bubble_factor;                      /* Cached time factor */
+    uint32_t bubble_los_epoch;              /* Time bubble epoch of the cached LoS check */
+    bool bubble_los;                        /* Cached "monsters in LoS" check */
     hturn bubble_change;                    /* Server turn we last changed colour */
     bool bubble_colour;                     /* Current warning colour for slow time bubbles */
     int bubble_speed;                       /* Current speed for slow time bubbles */
     uint32_t blink_speed;                   /* Current blink speed for slow time bubbles */
     int arena_num;                          /* What arena this guy is in */
+    struct chunk *roster_chunk;             /* Level whose roster we are on */
+    struct player *roster_prev;             /* Previous player on the same level */
+    struct player *roster_next;             /* Next player on the same level */
     uint32_t window_flag;
     bool prevents[128];                     /* Cache of "^" inscriptions */
     int16_t feeling;                        /* Most recent feeling */
@@ -367,6 +367,25 @@ int Sockbuf_copy(sockbuf_t *dest, sockbuf_t *src, int len)
 }
 
 
+/*
+ * Trade the contents of two socket buffers without copying any data.
+ * Each buffer keeps its socket and state.
+ */
+void Sockbuf_swap(sockbuf_t *a, sockbuf_t *b)
+{
+    sockbuf_t tmp = *a;
+
+    a->buf = b->buf;
+    a->size = b->size;
+    a->len = b->len;
+    a->ptr = b->ptr;
+    b->buf = tmp.buf;
+    b->size = tmp.size;
+    b->len = tmp.len;
+    b->ptr = tmp.ptr;
+}
+
+
 /*
  * Writes a packet to the socket
  *
@@ -819,3 +838,19 @@ int Packet_scanf(sockbuf_t *sbuf, char *fmt, ...)
 
     return (failure? -1: count);
 }
+
+
+/*
+ * Checks that "len" bytes can be read with the direct packet readers, reading
+ * more from the socket if allowed (same rules as Packet_scanf)
+ *
+ * Returns 1 if they can, 0 if the packet isn't complete yet, -1 on error
+ */
+int Packet_avail(sockbuf_t *sbuf, int len)
+{
+    if (&sbuf->buf[sbuf->len] >= &sbuf->ptr[len]) return 1;
+    if (BIT(sbuf->state, SOCKBUF_DGRAM | SOCKBUF_LOCK) != 0) return 0;
+    if (Sockbuf_read(sbuf) == -1) return -1;
+    if (&sbuf->buf[sbuf->len] >= &sbuf->ptr[len]) return 1;
+    return 0;
+}
@@ -49,8 +49,135 @@ extern int Sockbuf_flush(sockbuf_t *sbuf);
 extern int Sockbuf_write(sockbuf_t *sbuf, char *buf, int len);
 extern int Sockbuf_read(sockbuf_t *sbuf);
 extern int Sockbuf_copy(sockbuf_t *dest, sockbuf_t *src, int len);
+extern void Sockbuf_swap(sockbuf_t *a, sockbuf_t *b);
 
 extern int Packet_printf(sockbuf_t *, char *fmt, ...);
 extern int Packet_scanf(sockbuf_t *, char *fmt, ...);
+extern int Packet_avail(sockbuf_t *sbuf, int len);
+
+/*
+ * Direct packet writers
+ *
+ * Packet_reserve() checks once that a whole packet of "len" bytes fits and
+ * returns where to write it (NULL if it doesn't fit). The typed writers then
+ * store the fields without further checks, and Packet_commit() adds what was
+ * written to the buffer. The wire format is the same as Packet_printf().
+ */
+static inline char *Packet_reserve(sockbuf_t *sbuf, int len)
+{
+    /* Keep the spare byte that Packet_printf() leaves */
+    if (sbuf->len + len >= sbuf->size) return NULL;
+    return sbuf->buf + sbuf->len;
+}
+
+static inline int Packet_commit(sockbuf_t *sbuf, char *end)
+{
+    int count = end - (sbuf->buf + sbuf->len);
+
+    sbuf->len += count;
+    return count;
+}
+
+/* %c */
+static inline char *Packet_put_char(char *ptr, char cval)
+{
+    *ptr++ = cval;
+    return ptr;
+}
+
+/* %b */
+static inline char *Packet_put_byte(char *ptr, uint8_t bval)
+{
+    *ptr++ = (char)bval;
+    return ptr;
+}
+
+/* %hd */
+static inline char *Packet_put_s16(char *ptr, int16_t sval)
+{
+    *ptr++ = (char)(sval >> 8);
+    *ptr++ = (char)sval;
+    return ptr;
+}
+
+/* %hu */
+static inline char *Packet_put_u16(char *ptr, uint16_t usval)
+{
+    *ptr++ = (char)(usval >> 8);
+    *ptr++ = (char)usval;
+    return ptr;
+}
+
+/* %ld */
+static inline char *Packet_put_s32(char *ptr, int32_t lval)
+{
+    *ptr++ = (char)(lval >> 24);
+    *ptr++ = (char)(lval >> 16);
+    *ptr++ = (char)(lval >> 8);
+    *ptr++ = (char)lval;
+    return ptr;
+}
+
+/* %lu */
+static inline char *Packet_put_u32(char *ptr, uint32_t ulval)
+{
+    *ptr++ = (char)(ulval >> 24);
+    *ptr++ = (char)(ulval >> 16);
+    *ptr++ = (char)(ulval >> 8);
+    *ptr++ = (char)ulval;
+    return ptr;
+}
+
+/*
+ * Room taken by a string of at most "max" bytes (%s: NORMAL_WID, %S: MSG_LEN),
+ * including the terminating nul
+ */
+static inline int Packet_str_size(const char *str, int max)
+{
+    int len = (int)strlen(str) + 1;
+
+    return ((len > max)? max: len);
+}
+
+/* %s, %S (truncated to "max" bytes) */
+static inline char *Packet_put_str(char *ptr, const char *str, int max)
+{
+    int len = Packet_str_size(str, max) - 1;
+
+    memcpy(ptr, str, len);
+    ptr += len;
+    *ptr++ = '\0';
+    return ptr;
+}
+
+/*
+ * Direct packet readers: check once with Packet_avail() that "len" bytes can
+ * be read, then read the fields without further checks.
+ */
+static inline char Packet_get_char(sockbuf_t *sbuf)
+{
+    return *sbuf->ptr++;
+}
+
+static inline uint8_t Packet_get_byte(sockbuf_t *sbuf)
+{
+    return (uint8_t)(*sbuf->ptr++ & 0xFF);
+}
+
+static inline int16_t Packet_get_s16(sockbuf_t *sbuf)
+{
+    int16_t sval = (int16_t)(((sbuf->ptr[0] & 0xFF) << 8) | (sbuf->ptr[1] & 0xFF));
+
+    sbuf->ptr += 2;
+    return sval;
+}
+
+static inline uint16_t Packet_get_u16(sockbuf_t *sbuf)
+{
+    uint16_t usval = (uint16_t)(((sbuf->ptr[0] & 0xFF) << 8) | (sbuf->ptr[1] & 0xFF));
+
+    sbuf->ptr += 2;
+    return usval;
+}
 
 #endif
@@ -72,6 +72,9 @@
 #define RLE_CLASSIC 1
 #define RLE_LARGE 2
 
+/* Largest encoded size of "N" grids (a run never takes more than 3 bytes per grid) */
+#define RLE_MAX_SIZE(N) ((N) * 3)
+
 /*
  * Party commands
  */
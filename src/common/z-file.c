@@ -1421,6 +1421,20 @@ void file_flush(ang_file *f)
 }
 
 
+/*
+ * Flush file handle 'f' and make sure its data reached the disk
+ */
+bool file_sync(ang_file *f)
+{
+    if (fflush(f->fh) != 0) return false;
+#ifndef WINDOWS
+    if (fsync(fileno(f->fh)) != 0) return false;
+#endif
+
+    return true;
+}
+
+
 #ifdef WINDOWS
 long file_tell(ang_file *f)
 {
@@ -255,6 +255,7 @@ extern bool file_writec(ang_file *f, uint8_t b);
 
 /* fflush, ftell, rewind */
 extern void file_flush(ang_file *f);
+extern bool file_sync(ang_file *f);
 #ifdef WINDOWS
 extern long file_tell(ang_file *f);
 extern void file_rewind(ang_file *f);
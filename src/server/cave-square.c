@@ -260,7 +260,7 @@ bool feat_ismetamap(int feat)
  * SQUARE FEATURE PREDICATES
  *
  * These functions are used to figure out what kind of square something is,
- * via c->squares[y][x].feat (preferably accessed via square(c, grid)).
+ * via c->squares[y * c->width + x].feat (preferably accessed via square(c, grid)).
  * All direct testing of square(c, grid).feat should be rewritten
  * in terms of these functions.
  *
@@ -1537,14 +1537,14 @@ bool square_allows_summon(struct chunk *c, struct loc *grid)
 struct square *square(struct chunk *c, struct loc *grid)
 {
     my_assert(square_in_bounds(c, grid));
-    return &c->squares[grid->y][grid->x];
+    return &c->squares[grid->y * c->width + grid->x];
 }
 
 
 struct player_square *square_p(struct player *p, struct loc *grid)
 {
     my_assert(player_square_in_bounds(p, grid));
-    return &p->cave->squares[grid->y][grid->x];
+    return &p->cave->squares[grid->y * p->cave->width + grid->x];
 }
 
 
@@ -1616,6 +1616,7 @@ void square_excise_object(struct chunk *c, struct loc *grid, struct object *obj)
 {
     my_assert(square_in_bounds(c, grid));
     pile_excise(&square(c, grid)->obj, obj);
+    c->modified = true;
 
     /* Excise object index */
     c->o_gen[0 - (obj->oidx + 1)] = false;
@@ -1629,6 +1630,7 @@ void square_excise_object(struct chunk *c, struct loc *grid, struct object *obj)
         /* Clear the mimicry */
         mon->mimicked_obj = NULL;
         mflag_off(mon->mflag, MFLAG_CAMOUFLAGE);
+        update_mon_threats(mon);
     }
 
     /* Redraw */
@@ -1918,6 +1920,7 @@ void square_set_feat(struct chunk *c, struct loc *grid, int feat)
 
     /* Make the change */
     square(c, grid)->feat = feat;
+    c->modified = true;
 
     /* Light bright terrain */
     if (feat_is_bright(feat)) sqinfo_on(square(c, grid)->info, SQUARE_GLOW);
@@ -1958,6 +1961,7 @@ static void square_set_known_feat(struct player *p, struct loc *grid, int feat)
 void square_set_mon(struct chunk *c, struct loc *grid, int midx)
 {
     square(c, grid)->mon = midx;
+    c->modified = true;
 }
 
 
@@ -1967,6 +1971,7 @@ void square_set_mon(struct chunk *c, struct loc *grid, int midx)
 void square_set_obj(struct chunk *c, struct loc *grid, struct object *obj)
 {
     square(c, grid)->obj = obj;
+    c->modified = true;
 }
 
 
@@ -1976,6 +1981,7 @@ void square_set_obj(struct chunk *c, struct loc *grid, struct object *obj)
 void square_set_trap(struct chunk *c, struct loc *grid, struct trap *trap)
 {
     square(c, grid)->trap = trap;
+    c->modified = true;
 }
 
 
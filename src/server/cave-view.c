@@ -41,6 +41,9 @@ int distance(struct loc *grid1, struct loc *grid2)
 }
 
 
+typedef bool (*los_check)(void *data, struct loc *grid);
+
+
 /*
  * A simple, fast, integer-based line-of-sight algorithm.  By Joseph Hall,
  * 4116 Brewster Drive, Raleigh NC 27606.  Email to jnh@ecemwl.ncsu.edu.
@@ -69,6 +72,10 @@ int distance(struct loc *grid1, struct loc *grid2)
  * some special checks to avoid testing grids which are "brushed" but not
  * actually "entered".
  *
+ * The adjacent grids and the "knight move" situations are handled by the
+ * callers.  Here, "check" is called on each grid which must not block the
+ * line of sight, and we return false as soon as it returns false.
+ *
  * Angband three different "line of sight" type concepts, including this
  * function (which is used almost nowhere), the "project()" method (which
  * is used for determining the paths of projectables and spells and such),
@@ -77,7 +84,7 @@ int distance(struct loc *grid1, struct loc *grid2)
  * determining which grids are illuminated by the player's torch, and which
  * grids and monsters can be "seen" by the player, etc).
  */
-bool los(struct chunk *c, struct loc *grid1, struct loc *grid2)
+static bool los_walk(struct loc *grid1, struct loc *grid2, los_check check, void *data)
 {
     /* Delta */
     int dx, dy;
@@ -108,9 +115,6 @@ bool los(struct chunk *c, struct loc *grid1, struct loc *grid2)
     ay = ABS(dy);
     ax = ABS(dx);
 
-    /* Handle adjacent (or identical) grids */
-    if ((ax < 2) && (ay < 2)) return true;
-
     /* Directly South/North */
     if (!dx)
     {
@@ -120,7 +124,7 @@ bool los(struct chunk *c, struct loc *grid1, struct loc *grid2)
             scan.x = grid1->x;
             for (scan.y = grid1->y + 1; scan.y < grid2->y; scan.y++)
             {
-                if (!square_isprojectable(c, &scan)) return false;
+                if (!check(data, &scan)) return false;
             }
         }
 
@@ -130,7 +134,7 @@ bool los(struct chunk *c, struct loc *grid1, struct loc *grid2)
             scan.x = grid1->x;
             for (scan.y = grid1->y - 1; scan.y > grid2->y; scan.y--)
             {
-                if (!square_isprojectable(c, &scan)) return false;
+                if (!check(data, &scan)) return false;
             }
         }
 
@@ -147,7 +151,7 @@ bool los(struct chunk *c, struct loc *grid1, struct loc *grid2)
             scan.y = grid1->y;
             for (scan.x = grid1->x + 1; scan.x < grid2->x; scan.x++)
             {
-                if (!square_isprojectable(c, &scan)) return false;
+                if (!check(data, &scan)) return false;
             }
         }
 
@@ -157,7 +161,7 @@ bool los(struct chunk *c, struct loc *grid1, struct loc *grid2)
             scan.y = grid1->y;
             for (scan.x = grid1->x - 1; scan.x > grid2->x; scan.x--)
             {
-                if (!square_isprojectable(c, &scan)) return false;
+                if (!check(data, &scan)) return false;
             }
         }
 
@@ -169,14 +173,6 @@ bool los(struct chunk *c, struct loc *grid1, struct loc *grid2)
     sx = (dx < 0) ? -1 : 1;
     sy = (dy < 0) ? -1 : 1;
 
-    /* Vertical and horizontal "knights" */
-    loc_init(&scan, grid1->x, grid1->y + sy);
-    if ((ax == 1) && (ay == 2) && square_isprojectable(c, &scan))
-        return true;
-    loc_init(&scan, grid1->x + sx, grid1->y);
-    if ((ay == 1) && (ax == 2) && square_isprojectable(c, &scan))
-        return true;
-
     /* Calculate scale factor div 2 */
     f2 = (ax * ay);
 
@@ -205,7 +201,7 @@ bool los(struct chunk *c, struct loc *grid1, struct loc *grid2)
         /* the LOS exactly meets the corner of a tile. */
         while (grid2->x - scan.x)
         {
-            if (!square_isprojectable(c, &scan)) return false;
+            if (!check(data, &scan)) return false;
 
             qy += m;
 
@@ -214,7 +210,7 @@ bool los(struct chunk *c, struct loc *grid1, struct loc *grid2)
             else if (qy > f2)
             {
                 scan.y += sy;
-                if (!square_isprojectable(c, &scan)) return false;
+                if (!check(data, &scan)) return false;
                 qy -= f1;
                 scan.x += sx;
             }
@@ -248,7 +244,7 @@ bool los(struct chunk *c, struct loc *grid1, struct loc *grid2)
         /* the LOS exactly meets the corner of a tile. */
         while (grid2->y - scan.y)
         {
-            if (!square_isprojectable(c, &scan)) return false;
+            if (!check(data, &scan)) return false;
 
             qx += m;
 
@@ -257,7 +253,7 @@ bool los(struct chunk *c, struct loc *grid1, struct loc *grid2)
             else if (qx > f2)
             {
                 scan.x += sx;
-                if (!square_isprojectable(c, &scan)) return false;
+                if (!check(data, &scan)) return false;
                 qx -= f1;
                 scan.y += sy;
             }
@@ -275,6 +271,255 @@ bool los(struct chunk *c, struct loc *grid1, struct loc *grid2)
 }
 
 
+/*
+ * Precomputed line of sight paths
+ *
+ * The grids tested by los() only depend on the offset between the two grids,
+ * so they are computed once for all the offsets within viewing range.
+ */
+struct los_ray
+{
+    int start;          /* Index of the first grid in los_ray_grids */
+    int count;          /* Number of grids to test */
+};
+
+struct los_grid
+{
+    int8_t x;
+    int8_t y;
+};
+
+/* Upper bound on the radius of the precomputed paths (offsets are stored on 8 bits) */
+#define LOS_RADIUS_MAX  100
+
+static int los_radius = 0;
+static struct los_ray *los_rays = NULL;
+static bool *view_projectable = NULL;
+static struct los_grid *los_ray_grids = NULL;
+static int los_ray_grids_max = 0;
+static int los_ray_grids_size = 0;
+
+
+static bool los_record(void *data, struct loc *grid)
+{
+    if (los_ray_grids_max == los_ray_grids_size)
+    {
+        los_ray_grids_size = (los_ray_grids_size? 2 * los_ray_grids_size: 1024);
+        los_ray_grids = mem_realloc(los_ray_grids, los_ray_grids_size * sizeof(struct los_grid));
+    }
+    los_ray_grids[los_ray_grids_max].x = (int8_t)grid->x;
+    los_ray_grids[los_ray_grids_max].y = (int8_t)grid->y;
+    los_ray_grids_max++;
+
+    return true;
+}
+
+
+static struct los_ray *los_ray(int dx, int dy)
+{
+    return &los_rays[(dy + los_radius) * (2 * los_radius + 1) + dx + los_radius];
+}
+
+
+static void init_los_rays(void)
+{
+    struct loc origin, grid;
+
+    /* Viewing range (the Archer bonus adds one grid) */
+    los_radius = MIN(z_info->max_sight + 1, LOS_RADIUS_MAX);
+    los_rays = mem_zalloc((2 * los_radius + 1) * (2 * los_radius + 1) * sizeof(struct los_ray));
+    view_projectable = mem_zalloc((2 * los_radius + 1) * (2 * los_radius + 1) * sizeof(bool));
+
+    loc_init(&origin, 0, 0);
+    for (grid.y = -los_radius; grid.y <= los_radius; grid.y++)
+    {
+        for (grid.x = -los_radius; grid.x <= los_radius; grid.x++)
+        {
+            struct los_ray *ray = los_ray(grid.x, grid.y);
+
+            ray->start = los_ray_grids_max;
+            if ((ABS(grid.x) >= 2) || (ABS(grid.y) >= 2))
+                los_walk(&origin, &grid, los_record, NULL);
+            ray->count = los_ray_grids_max - ray->start;
+        }
+    }
+}
+
+
+static void cleanup_los_rays(void)
+{
+    mem_free(los_rays);
+    los_rays = NULL;
+    mem_free(view_projectable);
+    view_projectable = NULL;
+    mem_free(los_ray_grids);
+    los_ray_grids = NULL;
+    los_ray_grids_max = 0;
+    los_ray_grids_size = 0;
+    los_radius = 0;
+}
+
+
+struct init_module view_module =
+{
+    "view",
+    init_los_rays,
+    cleanup_los_rays
+};
+
+
+static bool los_projectable(void *data, struct loc *grid)
+{
+    return square_isprojectable((struct chunk *)data, grid);
+}
+
+
+/*
+ * Check the line of sight between two grids within viewing range, using the
+ * precomputed paths
+ */
+static bool los_ray_walk(struct loc *grid1, struct loc *grid2, los_check check, void *data)
+{
+    int dx = grid2->x - grid1->x;
+    int dy = grid2->y - grid1->y;
+    int ax = ABS(dx);
+    int ay = ABS(dy);
+    int sx = (dx < 0) ? -1 : 1;
+    int sy = (dy < 0) ? -1 : 1;
+    struct los_ray *ray;
+    struct loc scan;
+    int i;
+
+    /* Handle adjacent (or identical) grids */
+    if ((ax < 2) && (ay < 2)) return true;
+
+    /* Vertical and horizontal "knights" */
+    loc_init(&scan, grid1->x, grid1->y + sy);
+    if ((ax == 1) && (ay == 2) && check(data, &scan))
+        return true;
+    loc_init(&scan, grid1->x + sx, grid1->y);
+    if ((ay == 1) && (ax == 2) && check(data, &scan))
+        return true;
+
+    ray = los_ray(dx, dy);
+    for (i = ray->start; i < ray->start + ray->count; i++)
+    {
+        loc_init(&scan, grid1->x + los_ray_grids[i].x, grid1->y + los_ray_grids[i].y);
+        if (!check(data, &scan)) return false;
+    }
+
+    /* Assume los */
+    return true;
+}
+
+
+/*
+ * Remember which grids around the player are projectable, for the view update
+ */
+static void view_cache_projectable(struct chunk *c, struct loc *origin)
+{
+    struct loc grid;
+    int i = 0;
+
+    for (grid.y = origin->y - los_radius; grid.y <= origin->y + los_radius; grid.y++)
+    {
+        for (grid.x = origin->x - los_radius; grid.x <= origin->x + los_radius; grid.x++)
+            view_projectable[i++] = square_isprojectable(c, &grid);
+    }
+}
+
+
+static bool view_check(void *data, struct loc *grid)
+{
+    struct loc *origin = (struct loc *)data;
+
+    return view_projectable[(grid->y - origin->y + los_radius) * (2 * los_radius + 1) +
+        grid->x - origin->x + los_radius];
+}
+
+
+/*
+ * Check the line of sight between two grids
+ *
+ * Within viewing range, the grids to test come from the precomputed paths,
+ * which are built with los_walk() and so give the same results.
+ */
+bool los(struct chunk *c, struct loc *grid1, struct loc *grid2)
+{
+    int ax = ABS(grid2->x - grid1->x);
+    int ay = ABS(grid2->y - grid1->y);
+
+    /* Use the precomputed paths within viewing range */
+    if ((ax <= los_radius) && (ay <= los_radius))
+        return los_ray_walk(grid1, grid2, los_projectable, c);
+
+    /* Far away (neither adjacent nor a "knight's move" away) */
+    return los_walk(grid1, grid2, los_projectable, c);
+}
+
+
+/*
+ * Check the "knight's move" rule, which los_walk() leaves to its callers
+ */
+static bool los_knight(struct chunk *c, struct loc *grid1, struct loc *grid2)
+{
+    int dx = grid2->x - grid1->x;
+    int dy = grid2->y - grid1->y;
+    struct loc scan;
+
+    loc_init(&scan, grid1->x, grid1->y + ((dy < 0) ? -1 : 1));
+    if ((ABS(dx) == 1) && (ABS(dy) == 2) && square_isprojectable(c, &scan))
+        return true;
+    loc_init(&scan, grid1->x + ((dx < 0) ? -1 : 1), grid1->y);
+    if ((ABS(dy) == 1) && (ABS(dx) == 2) && square_isprojectable(c, &scan))
+        return true;
+
+    return false;
+}
+
+
+/*
+ * Check the precomputed paths against los_walk() on a level
+ *
+ * Both los() and the paths used by the view update are compared with the
+ * arithmetic for every pair of grids within viewing range. Returns the number
+ * of pairs that disagree; the number of pairs tested is put in "pairs".
+ */
+long los_test(struct chunk *c, long *pairs)
+{
+    struct loc grid1, grid2;
+    long errors = 0;
+
+    *pairs = 0;
+    for (grid1.y = 0; grid1.y < c->height; grid1.y++)
+    {
+        for (grid1.x = 0; grid1.x < c->width; grid1.x++)
+        {
+            view_cache_projectable(c, &grid1);
+
+            for (grid2.y = grid1.y - los_radius; grid2.y <= grid1.y + los_radius; grid2.y++)
+            {
+                for (grid2.x = grid1.x - los_radius; grid2.x <= grid1.x + los_radius; grid2.x++)
+                {
+                    bool expected;
+
+                    if (!square_in_bounds(c, &grid2)) continue;
+
+                    expected = (los_knight(c, &grid1, &grid2) ||
+                        los_walk(&grid1, &grid2, los_projectable, c));
+                    if (los(c, &grid1, &grid2) != expected) errors++;
+                    else if (los_ray_walk(&grid1, &grid2, view_check, &grid1) != expected)
+                        errors++;
+                    (*pairs)++;
+                }
+            }
+        }
+    }
+
+    return errors;
+}
+
+
 /*
  * Some comments on the dungeon related data structures and functions...
  *
@@ -454,17 +699,60 @@ bool los(struct chunk *c, struct loc *grid1, struct loc *grid2)
  */
 
 
+/*
+ * Maximum distance at which the player can view a grid
+ */
+static int player_max_vision(struct player *p)
+{
+    int max_vision = z_info->max_sight; // Tangaria
+
+    if (streq(p->clazz->name, "Archer"))
+        max_vision++;
+
+    /* The precomputed paths don't go any farther */
+    return MIN(max_vision, los_radius);
+}
+
+
+/*
+ * Get the area of the chunk where grids can be in view (end excluded)
+ *
+ * Only grids within that area, plus the grids of the area used by the previous
+ * update, can change when the view is updated.
+ */
+static void view_area(struct player *p, struct chunk *c, struct loc *begin, struct loc *end)
+{
+    int max_vision = player_max_vision(p);
+
+    loc_init(begin, MAX(p->grid.x - max_vision, 0), MAX(p->grid.y - max_vision, 0));
+    loc_init(end, MIN(p->grid.x + max_vision + 1, c->width),
+        MIN(p->grid.y + max_vision + 1, c->height));
+}
+
+
+static bool area_is_empty(struct loc *begin, struct loc *end)
+{
+    return ((begin->x >= end->x) || (begin->y >= end->y));
+}
+
+
+static bool area_contains(struct loc *begin, struct loc *end, struct loc *grid)
+{
+    return ((grid->x >= begin->x) && (grid->x < end->x) && (grid->y >= begin->y) &&
+        (grid->y < end->y));
+}
+
+
 /*
  * Mark the currently seen grids, then wipe in preparation for recalculating
  */
-static void mark_wasseen(struct player *p, struct chunk *c)
+static void mark_wasseen(struct player *p, struct loc *begin, struct loc *end)
 {
-    struct loc begin, end;
     struct loc_iterator iter;
 
-    loc_init(&begin, 0, 0);
-    loc_init(&end, c->width, c->height);
-    loc_iterator_first(&iter, &begin, &end);
+    if (area_is_empty(begin, end)) return;
+
+    loc_iterator_first(&iter, begin, end);
 
     /* Save the old "view" grids for later */
     do
@@ -672,7 +960,8 @@ static bool glow_can_light_wall(struct chunk *c, struct player *p, struct loc *w
  * propagating the light out from the source and terminating paths when they
  * reach a wall.
  */
-static void add_light(struct chunk *c, struct player *p, struct loc *sgrid, int radius, int inten)
+static void add_light(struct chunk *c, struct player *p, struct loc *sgrid, int radius, int inten,
+    struct loc *area_begin, struct loc *area_end)
 {
     struct loc begin, end;
     struct loc_iterator iter;
@@ -692,6 +981,9 @@ static void add_light(struct chunk *c, struct player *p, struct loc *sgrid, int
         if (!square_in_bounds(c, &grid)) continue;
         if (dist > radius) continue;
 
+        /* Only the light in the view area matters */
+        if (!area_contains(area_begin, area_end, &grid)) continue;
+
         /* Don't propagate the light through walls. */
         if (!los(c, sgrid, &grid)) continue;
 
@@ -716,8 +1008,12 @@ static void add_light(struct chunk *c, struct player *p, struct loc *sgrid, int
 
 /*
  * Calculate light level for every grid in view - stolen from Sil
+ *
+ * Only the grids in the view area (area_begin to area_end) get a correct light
+ * level.
  */
-static void calc_lighting(struct player *p, struct chunk *c)
+static void calc_lighting(struct player *p, struct chunk *c, struct loc *area_begin,
+    struct loc *area_end)
 {
     int dir, k;
     int light = p->state.cur_light;
@@ -725,7 +1021,7 @@ static void calc_lighting(struct player *p, struct chunk *c)
     int old_light = p->square_light;
     struct loc begin, end;
     struct loc_iterator iter;
-    int max_vision = z_info->max_sight; // Tangaria
+    int max_vision = player_max_vision(p);
 
     // Darkness-loving races don't depends on light sources.. on the contrary
     if (streq(p->race->name, "Troglodyte") || streq(p->race->name, "Vampire") ||
@@ -786,12 +1082,14 @@ static void calc_lighting(struct player *p, struct chunk *c)
 
     radius = ABS(light) - 1;
 
-    loc_init(&begin, 0, 0);
-    loc_init(&end, c->width, c->height);
+    /*
+     * Each scanned grid resets its own light, so a grid only keeps the light added
+     * by the bright grids scanned after it: the one to its right and the three
+     * below. Also scan the row below and the columns on each side of the view area.
+     */
+    loc_init(&begin, MAX(area_begin->x - 1, 0), area_begin->y);
+    loc_init(&end, MIN(area_end->x + 1, c->width), MIN(area_end->y + 1, c->height));
     loc_iterator_first(&iter, &begin, &end);
-    
-    if (streq(p->clazz->name, "Archer"))
-        max_vision++;
 
     /* Starting values based on permanent light */
     do
@@ -828,7 +1126,7 @@ static void calc_lighting(struct player *p, struct chunk *c)
     while (loc_iterator_next_strict(&iter));
 
     /* Light around the player */
-    if (light) add_light(c, p, &p->grid, radius, light);
+    if (light) add_light(c, p, &p->grid, radius, light, area_begin, area_end);
 
     /* Scan monster list and add monster light or darkness */
     for (k = 1; k < cave_monster_max(c); k++)
@@ -853,7 +1151,7 @@ static void calc_lighting(struct player *p, struct chunk *c)
         if (distance(&p->grid, &mon->grid) - radius > max_vision) continue;
 
         /* Light or darken around the monster */
-        add_light(c, p, &mon->grid, radius, light);
+        add_light(c, p, &mon->grid, radius, light, area_begin, area_end);
     }
 
     /* Scan player list and add player lights */
@@ -882,7 +1180,7 @@ static void calc_lighting(struct player *p, struct chunk *c)
         if (distance(&p->grid, &q->grid) - radius > max_vision) continue;
 
         /* Light or darken around the player */
-        add_light(c, p, &q->grid, radius, light);
+        add_light(c, p, &q->grid, radius, light, area_begin, area_end);
     }
 
     /* Update light level indicator */
@@ -940,12 +1238,9 @@ static void update_view_one(struct player *p, struct chunk *c, struct loc *grid)
     int d = distance(grid, &p->grid);
     bool close = ((d < p->state.cur_light)? true: false);
     struct loc cgrid;
-    int max_vision = z_info->max_sight; // Tangaria    
+    int max_vision = player_max_vision(p);
 
     loc_copy(&cgrid, grid);
-    
-    if (streq(p->clazz->name, "Archer"))
-        max_vision++;
 
     /* Too far away */
     if (d > max_vision) return;
@@ -1013,7 +1308,7 @@ static void update_view_one(struct player *p, struct chunk *c, struct loc *grid)
         }
     }
 
-    if (los(c, &p->grid, &cgrid))
+    if (los_ray_walk(&p->grid, &cgrid, view_check, &p->grid))
         become_viewable(p, c, grid, close);
 }
 
@@ -1079,17 +1374,29 @@ static void update_one(struct player *p, struct chunk *c, struct loc *grid)
 
 /*
  * Update the player's current view
+ *
+ * Only the grids within viewing range, plus the ones that were within range at
+ * the previous update, are scanned.
  */
 void update_view(struct player *p, struct chunk *c)
 {
-    struct loc begin, end;
+    struct loc begin, end, old_begin, old_end;
     struct loc_iterator iter;
 
+    /* Get the view area, and the one of the previous update */
+    view_area(p, c, &begin, &end);
+    loc_init(&old_begin, p->cave->view_begin.x, p->cave->view_begin.y);
+    loc_init(&old_end, MIN(p->cave->view_end.x, c->width), MIN(p->cave->view_end.y, c->height));
+
     /* Record the current view */
-    mark_wasseen(p, c);
+    mark_wasseen(p, &old_begin, &old_end);
+    mark_wasseen(p, &begin, &end);
 
     /* Calculate light levels */
-    calc_lighting(p, c);
+    calc_lighting(p, c, &begin, &end);
+
+    /* Get the walls around the player */
+    view_cache_projectable(c, &p->grid);
 
     /* Assume we can view the player grid */
     sqinfo_on(square_p(p, &p->grid)->info, SQUARE_VIEW);
@@ -1100,8 +1407,6 @@ void update_view(struct player *p, struct chunk *c)
         sqinfo_on(square_p(p, &p->grid)->info, SQUARE_CLOSE_PLAYER);
     }
 
-    loc_init(&begin, 0, 0);
-    loc_init(&end, c->width, c->height);
     loc_iterator_first(&iter, &begin, &end);
 
     /*
@@ -1130,6 +1435,21 @@ void update_view(struct player *p, struct chunk *c)
         update_one(p, c, &iter.cur);
     }
     while (loc_iterator_next_strict(&iter));
+
+    /* Update the grids which are no longer in the view area */
+    if (!area_is_empty(&old_begin, &old_end))
+    {
+        loc_iterator_first(&iter, &old_begin, &old_end);
+        do
+        {
+            if (!area_contains(&begin, &end, &iter.cur)) update_one(p, c, &iter.cur);
+        }
+        while (loc_iterator_next_strict(&iter));
+    }
+
+    /* Remember the view area */
+    loc_copy(&p->cave->view_begin, &begin);
+    loc_copy(&p->cave->view_end, &end);
 }
 
 
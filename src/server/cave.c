@@ -289,12 +289,25 @@ int lookup_feat_code(const char *code)
 }
 
 
+/*
+ * Point the squares of a chunk to their info flags
+ */
+static void cave_link_info(struct chunk *c)
+{
+    int i, n = c->height * c->width;
+
+    for (i = 0; i < n; i++) c->squares[i].info = &c->info[i * SQUARE_SIZE];
+}
+
+
 /*
  * Allocate a new chunk of the world
+ *
+ * The squares and their info flags are kept in two flat arrays, so that a level
+ * only takes a handful of allocations and grid scans walk memory linearly.
  */
 struct chunk *cave_new(int height, int width)
 {
-    struct loc grid;
     struct chunk *c = mem_zalloc(sizeof(*c));
 
     c->height = height;
@@ -302,13 +315,9 @@ struct chunk *cave_new(int height, int width)
 
     c->feat_count = mem_zalloc(FEAT_MAX * sizeof(int));
 
-    c->squares = mem_zalloc(c->height * sizeof(struct square*));
-    for (grid.y = 0; grid.y < c->height; grid.y++)
-    {
-        c->squares[grid.y] = mem_zalloc(c->width * sizeof(struct square));
-        for (grid.x = 0; grid.x < c->width; grid.x++)
-            square(c, &grid)->info = mem_zalloc(SQUARE_SIZE * sizeof(bitflag));
-    }
+    c->squares = mem_zalloc(c->height * c->width * sizeof(struct square));
+    c->info = mem_zalloc(c->height * c->width * SQUARE_SIZE * sizeof(bitflag));
+    cave_link_info(c);
 
     c->monsters = mem_zalloc(z_info->level_monster_max * sizeof(struct monster));
     c->mon_max = 1;
@@ -317,6 +326,7 @@ struct chunk *cave_new(int height, int width)
 
     c->o_gen = mem_zalloc(MAX_OBJECTS * sizeof(bool));
     c->join = mem_zalloc(sizeof(struct connector));
+    c->chunk_idx = -1;
 
     return c;
 }
@@ -333,25 +343,52 @@ void cave_free(struct chunk *c)
     {
         for (grid.x = 0; grid.x < c->width; grid.x++)
         {
-            mem_free(square(c, &grid)->info);
             if (square(c, &grid)->trap)
                 square_free_trap(c, &grid);
             if (square(c, &grid)->obj)
                 object_pile_free(square(c, &grid)->obj);
         }
-        mem_free(c->squares[grid.y]);
     }
     mem_free(c->squares);
+    mem_free(c->info);
 
     mem_free(c->feat_count);
     mem_free(c->monsters);
     mem_free(c->monster_groups);
     mem_free(c->o_gen);
     mem_free(c->join);
+    level_image_free(c);
     mem_free(c);
 }
 
 
+/*
+ * Change the width of a chunk, keeping the contents of the remaining squares
+ *
+ * New squares are empty.
+ */
+void cave_set_width(struct chunk *c, int width)
+{
+    struct square *squares = mem_zalloc(c->height * width * sizeof(struct square));
+    bitflag *info = mem_zalloc(c->height * width * SQUARE_SIZE * sizeof(bitflag));
+    int y, w = MIN(c->width, width);
+
+    for (y = 0; y < c->height; y++)
+    {
+        memcpy(&squares[y * width], &c->squares[y * c->width], w * sizeof(struct square));
+        memcpy(&info[y * width * SQUARE_SIZE], &c->info[y * c->width * SQUARE_SIZE],
+            w * SQUARE_SIZE * sizeof(bitflag));
+    }
+
+    mem_free(c->squares);
+    mem_free(c->info);
+    c->squares = squares;
+    c->info = info;
+    c->width = width;
+    cave_link_info(c);
+}
+
+
 /*
  * Standard "find me a location" function, now with all legal outputs!
  *
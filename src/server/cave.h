@@ -95,7 +95,8 @@ struct chunk
     int width;
     int *feat_count;
 
-    struct square **squares;
+    struct square *squares;     /* height * width squares, row by row */
+    bitflag *info;              /* height * width * SQUARE_SIZE square info flags */
     struct loc decoy;
 
     struct monster *monsters;
@@ -116,6 +117,16 @@ struct chunk
     bool gen_hack;
 
     int profile;
+    int chunk_idx;
+    struct player *players;
+
+    /* Savefile data from the last autosave, kept until the level is modified */
+    bool modified;
+    struct level_image *image;
+
+    int16_t idle;               /* Minutes without players (levels saved apart) */
+    int16_t saving;             /* Background saves of its own file not done yet */
+    uint32_t save_id;           /* Tells its saves from those of a former level at the same place */
 };
 
 /*
@@ -153,6 +164,7 @@ extern void next_grid(struct loc *next, struct loc *grid, int dir);
 extern int lookup_feat_code(const char *code);
 extern struct chunk *cave_new(int height, int width);
 extern void cave_free(struct chunk *c);
+extern void cave_set_width(struct chunk *c, int width);
 extern bool scatter(struct chunk *c, struct loc *place, struct loc *grid, int d, bool need_los);
 extern int scatter_ext(struct chunk *c, struct loc *places, int n, struct loc *grid, int d,
     bool need_los, bool (*pred)(struct chunk *, struct loc *));
@@ -447,6 +459,7 @@ extern void square_set_rubble(struct chunk *c, struct loc *grid, int feat);
 /* cave-view.c */
 extern int distance(struct loc *grid1, struct loc *grid2);
 extern bool los(struct chunk *c, struct loc *grid1, struct loc *grid2);
+extern long los_test(struct chunk *c, long *pairs);
 extern void update_view(struct player *p, struct chunk *c);
 extern bool no_light(struct player *p);
 
@@ -830,6 +830,7 @@ void leave_depth(struct player *p, struct chunk *c)
 
     /* One less player here */
     chunk_decrease_player_count(&p->wpos);
+    chunk_roster_remove(p);
 
     /* Free monsters from slavery */
     for (i = 1; i < cave_monster_max(c); i++)
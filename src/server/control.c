@@ -40,11 +40,13 @@ typedef struct
 
 static void console_who(int ind, char *dummy);
 static void console_debug(int ind, char *dummy);
+static void console_packets(int ind, char *name);
 static void console_listen(int ind, char *channel);
 static void console_whois(int ind, char *name);
 static void console_message(int ind, char *buf);
 static void console_kick_player(int ind, char *name);
 static void console_rng_test(int ind, char *dummy);
+static void console_los_test(int ind, char *dummy);
 static void console_reload(int ind, char *mod);
 static void console_shutdown(int ind, char *dummy);
 static void console_wrath(int ind, char *name);
@@ -64,7 +66,9 @@ static console_command_ops console_commands[] =
     {"reload", console_reload, 1, "config|news\nReload mangband.cfg or news.txt"},
     {"whois", console_whois, 1, "PLAYERNAME\nDetailed player information"},
     {"rngtest", console_rng_test, 0, "\nPerform RNG test"},
+    {"lostest", console_los_test, 0, "\nCheck the precomputed line of sight on the levels in memory (slow)"},
     {"debug", console_debug, 0, "\nUnused"},
+    {"packets", console_packets, 0, "[PLAYERNAME]\nTraffic per packet type, for the server or a player"},
     {"warn", console_restart_warning, 0, "\nWarn players about server restart"}
 };
 
@@ -337,6 +341,54 @@ static void console_debug(int ind, char *dummy)
 }
 
 
+/*
+ * Show the traffic per packet type, for the whole server or for one player
+ * (along with the data queued for that player)
+ */
+static void console_packets(int ind, char *name)
+{
+    int i, len, conn = 0;
+    struct player *p = NULL, *p_ptr_search;
+    sockbuf_t *console_buf_w = (sockbuf_t*)console_buffer(ind, CONSOLE_WRITE);
+    char buf[NORMAL_WID];
+
+    if (name)
+    {
+        /* Find this player */
+        for (i = 1; i <= NumPlayers; i++)
+        {
+            p_ptr_search = player_get(i);
+            len = strlen(p_ptr_search->name);
+            if (!my_strnicmp(p_ptr_search->name, name, len))
+                p = p_ptr_search;
+        }
+        if (!p)
+        {
+            Packet_printf(console_buf_w, "%s%c", "No such player", (int)'\n');
+            Sockbuf_flush(console_buf_w);
+            return;
+        }
+        conn = p->conn;
+    }
+
+    Packet_printf(console_buf_w, "%S", PACKET_STATS_HEADER);
+    for (i = 0; i < PKT_MAX; i++)
+    {
+        if (packet_stats_line(conn, i, buf, sizeof(buf)))
+            Packet_printf(console_buf_w, "%S", buf);
+    }
+    if (p)
+    {
+        long in, out;
+
+        Conn_get_queued(conn, &in, &out);
+        strnfmt(buf, sizeof(buf), "Queued: %ld bytes in, %ld bytes out\n", in, out);
+        Packet_printf(console_buf_w, "%S", buf);
+    }
+    Sockbuf_flush(console_buf_w);
+}
+
+
 /*  
  * Start listening to game server messages
  */
@@ -517,6 +569,43 @@ static void console_rng_test(int ind, char *dummy)
 }
 
 
+/*
+ * Check the precomputed line of sight paths against the arithmetic on every
+ * level in memory
+ */
+static void console_los_test(int ind, char *dummy)
+{
+    sockbuf_t *console_buf_w = (sockbuf_t*)console_buffer(ind, CONSOLE_WRITE);
+    char terminator = '\n';
+    long pairs, errors, total = 0;
+    int i;
+
+    /* Let the operator know we are busy */
+    Packet_printf(console_buf_w, "%s%c", "Comparing line of sight paths...", (int)terminator);
+    Sockbuf_flush(console_buf_w);
+
+    for (i = 0; i < chunk_list_max(); i++)
+    {
+        struct chunk *c = chunk_list_at(i);
+
+        if (!c) continue;
+
+        errors = los_test(c, &pairs);
+        total += errors;
+        Packet_printf(console_buf_w, "%s",
+            format("Level (%d, %d) at %dft: %ld pairs, %ld differences\n", c->wpos.grid.x,
+            c->wpos.grid.y, c->wpos.depth * 50, pairs, errors));
+    }
+
+    /* Display the results */
+    if (total)
+        Packet_printf(console_buf_w, "%s%c", "Line of sight check FAILED", (int)terminator);
+    else
+        Packet_printf(console_buf_w, "%s%c", "Line of sight is working perfectly", (int)terminator);
+    Sockbuf_flush(console_buf_w);
+}
+
+
 static void console_reload(int ind, char *mod)
 {
     sockbuf_t *console_buf_w = (sockbuf_t*)console_buffer(ind, CONSOLE_WRITE);
@@ -1959,6 +1959,15 @@ static const flag_event_trigger redraw_events[] =
 };
 
 
+/*
+ * Redraws that follow a change to what goes in the player savefile
+ * (level, experience, stats, hit points, mana, timed effects, gold, gear, spells)
+ */
+#define PR_SAVEFILE \
+    (PR_MISC | PR_TITLE | PR_LEV | PR_EXP | PR_STATS | PR_HP | PR_MANA | PR_STATUS | PR_GOLD | \
+    PR_INVEN | PR_EQUIP | PR_SPELL)
+
+
 /*
  * Handle "p->upkeep->redraw"
  */
@@ -1969,6 +1978,9 @@ void redraw_stuff(struct player *p)
     /* Nothing to do */
     if (!p->upkeep->redraw) return;
 
+    /* The savefile is out of date */
+    if (p->upkeep->redraw & PR_SAVEFILE) p->upkeep->dirty = true;
+
     /* Character is not ready yet, no screen updates */
     if (!p->alive) return;
 
@@ -3115,33 +3127,14 @@ int move_energy(int depth)
  */
 bool monsters_in_los(struct player *p, struct chunk *c)
 {
-    int i;
-
-    /* If nothing in LoS */
-    for (i = 1; i < cave_monster_max(c); i++)
-    {
-        struct monster *mon = cave_monster(c, i);
-        bool incapacitated = (mon->m_timed[MON_TMD_SLEEP] || mon->m_timed[MON_TMD_HOLD]);
-
-        /* PWMAngband: don't count non hostile monsters */
-        if (!pvm_check(p, mon)) continue;
-
-        /* PWMAngband: skip if the monster is hidden */
-        if (monster_is_camouflaged(mon)) continue;
-
-        /* PWMAngband: if disturb_nomove isn't set, allow nonmovable monsters */
-        if (rf_has(mon->race->flags, RF_NEVER_MOVE) && !OPT(p, disturb_nomove))
-            incapacitated = true;
+    struct player *q;
 
-        /* Check this monster */
-        if (monster_is_in_view(p, i) && !incapacitated) return true;
-    }
+    /* Hostile monsters in view are counted by update_mon_threat() */
+    if (p->threats_in_view > 0) return true;
 
     /* Hostile players count as monsters */
-    for (i = 1; i <= NumPlayers; i++)
+    for (q = c->players; q; q = q->roster_next)
     {
-        struct player *q = player_get(i);
-
         /* Only count connected players XXX */
         if (q->conn == -1) continue;
 
@@ -3149,13 +3142,50 @@ bool monsters_in_los(struct player *p, struct chunk *c)
         if (!pvp_check(p, q, PVP_CHECK_BOTH, true, 0x00)) continue;
 
         /* Check this player */
-        if (player_is_in_view(p, i) && !q->timed[TMD_PARALYZED]) return true;
+        if (player_is_in_view(p, get_player_index(get_connection(q->conn))) &&
+            !q->timed[TMD_PARALYZED])
+        {
+            return true;
+        }
     }
 
     return false;
 }
 
 
+/*
+ * Time bubbles are expensive to compute: monsters_in_los() scans the whole level and
+ * base_time_factor() recurses over all nearby players. Since they are needed for every
+ * monster every turn, the results are cached on each player and only recomputed once
+ * per "epoch". A new epoch is started by reset_time_bubbles().
+ */
+static uint32_t bubble_epoch = 1;
+
+
+/*
+ * Start a new time bubble epoch, invalidating all cached time bubbles.
+ */
+void reset_time_bubbles(void)
+{
+    bubble_epoch++;
+}
+
+
+/*
+ * Cached version of monsters_in_los(), valid for the current time bubble epoch.
+ */
+bool monsters_in_los_cached(struct player *p, struct chunk *c)
+{
+    if (p->bubble_los_epoch != bubble_epoch)
+    {
+        p->bubble_los = monsters_in_los(p, c);
+        p->bubble_los_epoch = bubble_epoch;
+    }
+
+    return p->bubble_los;
+}
+
+
 /*
  * Determine the speed of a given players "time bubble" and return a percentage
  * scaling factor which should be applied to any amount of energy granted to
@@ -3171,20 +3201,15 @@ bool monsters_in_los(struct player *p, struct chunk *c)
  */
 static int base_time_factor(struct player *p, struct chunk *c, int slowest)
 {
-    int i, timefactor, health;
+    struct player *q;
+    int timefactor, health;
     bool los;
 
     /* Paranoia */
     if (!p) return NORMAL_TIME;
 
     /* If this is the initial call, reset time bubble check for all players on the level */
-    for (i = 1; !slowest && (i <= NumPlayers); i++)
-    {
-        struct player *q = player_get(i);
-
-        if (!wpos_eq(&q->wpos, &p->wpos)) continue;
-        q->bubble_checked = false;
-    }
+    for (q = c->players; !slowest && q; q = q->roster_next) q->bubble_checked = false;
 
     /* Normal time scale */
     timefactor = NORMAL_TIME;
@@ -3206,7 +3231,7 @@ static int base_time_factor(struct player *p, struct chunk *c, int slowest)
     }
 
     /* If nothing in LoS */
-    los = monsters_in_los(p, c);
+    los = monsters_in_los_cached(p, c);
 
     /* Prevent too much manual slowdown */
     if ((p->opts.hitpoint_warn > 9) && !los) timefactor = NORMAL_TIME;
@@ -3230,15 +3255,11 @@ static int base_time_factor(struct player *p, struct chunk *c, int slowest)
     /* We have checked our time bubble */
     p->bubble_checked = true;
 
-    /* Check all other players within our range */
-    for (i = 1; i <= NumPlayers; i++)
+    /* Check all other players on the level within our range */
+    for (q = c->players; q; q = q->roster_next)
     {
-        struct player *q = player_get(i);
         int dist;
 
-        /* Skip him if he's on a different dungeon level */
-        if (!wpos_eq(&q->wpos, &p->wpos)) continue;
-
         /* Only check them if they haven't already been checked */
         if (q->bubble_checked) continue;
 
@@ -3332,11 +3353,17 @@ int time_factor(struct player *p, struct chunk *c)
     /* Paranoia */
     if (!p) return NORMAL_TIME;
 
+    /* Already computed during this epoch */
+    if (p->bubble_epoch == bubble_epoch) return p->bubble_factor;
+
     /* Use basic time scaling in towns */
-    if (in_town(&p->wpos)) return base_time_factor_simple(p, 0);
+    if (in_town(&p->wpos)) p->bubble_factor = base_time_factor_simple(p, 0);
 
     /* Scale our time by our bubbles time factor */
-    return base_time_factor(p, c, 0);
+    else p->bubble_factor = base_time_factor(p, c, 0);
+
+    p->bubble_epoch = bubble_epoch;
+    return p->bubble_factor;
 }
 
 
@@ -681,6 +681,7 @@ static void process_world(struct player *p, struct chunk *c)
                 if (trap->timeout)
                 {
                     trap->timeout--;
+                    c->modified = true;
                     if (!trap->timeout) square_light_spot(c, &iter.cur);
                 }
                 trap = trap->next;
@@ -1869,34 +1870,26 @@ static void on_new_level(void)
 static void on_leave_level(void)
 {
     int i;
-    struct loc grid;
 
     /* Deallocate any unused levels */
-    for (grid.y = radius_wild; grid.y >= 0 - radius_wild; grid.y--)
+    for (i = 0; i < chunk_list_max(); i++)
     {
-        for (grid.x = 0 - radius_wild; grid.x <= radius_wild; grid.x++)
-        {
-            struct wild_type *w_ptr = get_wt_info_at(&grid);
+        struct chunk *c = chunk_list_at(i);
 
-            /* Caves */
-            for (i = 0; i <= w_ptr->max_depth - w_ptr->min_depth; i++)
-            {
-                if (!w_ptr->chunk_list[i]) continue;
+        if (!c) continue;
 
-                /* Don't deallocate special levels */
-                // note: it doesn't count DM! When testing - use regular char
-                if (level_keep_allocated(w_ptr->chunk_list[i])) continue;
+        /* Don't deallocate special levels */
+        // note: it doesn't count DM! When testing - use regular char
+        if (level_keep_allocated(c)) continue;
 
-                // also exist in admin menu
-                /* Deallocate custom houses */
-                // ..in T we also do this at dusk_or_dawn() in wipe_old_houses()
-                wipe_custom_houses(&w_ptr->chunk_list[i]->wpos);
+        // also exist in admin menu
+        /* Deallocate custom houses */
+        // ..in T we also do this at dusk_or_dawn() in wipe_old_houses()
+        wipe_custom_houses(&c->wpos);
 
-                /* Deallocate the level */
-                cave_wipe(w_ptr->chunk_list[i]);
-                w_ptr->chunk_list[i] = NULL;
-            }
-        }
+        /* Deallocate the level */
+        chunk_list_remove(c);
+        cave_wipe(c);
     }
 }
 
@@ -1935,9 +1928,9 @@ static void process_various(void)
     {
         int i;
 
-        /* Save server state + player names */
-        save_server_info(false);
-        save_account_info(false);
+        /* Save server state + player names (written in the background) */
+        autosave_server_info();
+        autosave_account_info();
 
         /* Save each player */
         for (i = 1; i <= NumPlayers; i++)
@@ -1945,10 +1938,13 @@ static void process_various(void)
             struct player *p = player_get(i);
 
             /* Save this player */
-            if (!p->upkeep->funeral) save_player(p, false);
+            if (!p->upkeep->funeral) autosave_player(p);
         }
     }
 
+    /* Report the background saves that failed */
+    autosave_check();
+
     /* Handle certain things once a minute */
     if (!(turn.turn % (cfg_fps * 60)))
     {
@@ -2027,6 +2023,29 @@ static void process_various(void)
                 }
             }
         }
+
+        /* Swap out the static levels nobody has been on for a while */
+        for (i = 0; i < chunk_list_max(); i++)
+        {
+            struct chunk *c = chunk_list_at(i);
+            struct worldpos wpos;
+
+            if (!c) continue;
+
+            if (c->players || !level_keep_allocated(c) || !level_saved_apart(&c->wpos))
+            {
+                c->idle = 0;
+                continue;
+            }
+            if (++c->idle < LEVEL_SWAP_OUT) continue;
+
+            /* Write the level to its savefile in the background, free it once that's done */
+            if (!autosave_level(c)) continue;
+            memcpy(&wpos, &c->wpos, sizeof(struct worldpos));
+            chunk_list_remove(c);
+            cave_release(c);
+            chunk_set_on_disk(&wpos, true);
+        }
     }
 
     /* Grow crops very occasionally */
@@ -2383,6 +2402,12 @@ static void generate_new_level(struct player *p)
     /* Paranoia */
     if (!chunk_has_players(&p->wpos)) return;
 
+    /* Bring back a level swapped out to disk */
+    if (!c) c = load_level(&p->wpos);
+
+    /* Forget the hostile monsters seen on the previous level */
+    forget_mon_threats(p);
+
 ////* Play ambient sound on change of level. */
 
     // north areas always got snow
@@ -2669,7 +2694,7 @@ static void energize_player(struct player *p)
 {
     int energy;
     struct chunk *c = chunk_get(&p->wpos);
-    bool allow_running = (in_town(&c->wpos) || !monsters_in_los(p, c));
+    bool allow_running = (in_town(&c->wpos) || !monsters_in_los_cached(p, c));
 
     /* Player is idle */
     bool is_idle = has_energy(p, false);
@@ -2766,7 +2791,7 @@ static void energize_monsters(struct chunk *c)
         /* If we are within a player's time bubble, scale our energy */
         if (mon->closest_player)
         {
-            bool allow_running = (!in_town(&c->wpos) && !monsters_in_los(mon->closest_player, c));
+            bool allow_running = (!in_town(&c->wpos) && !monsters_in_los_cached(mon->closest_player, c));
 
             energy = energy * time_factor(mon->closest_player, c) / 100;
 
@@ -2791,7 +2816,6 @@ static void energize_monsters(struct chunk *c)
 static void pre_turn_game_loop(void)
 {
     int i;
-    struct loc grid;
 
     on_new_level();
 
@@ -2799,19 +2823,11 @@ static void pre_turn_game_loop(void)
     Net_input();
 
     /* Process monsters with even more energy first */
-    for (grid.y = radius_wild; grid.y >= 0 - radius_wild; grid.y--)
+    for (i = 0; i < chunk_list_max(); i++)
     {
-        for (grid.x = 0 - radius_wild; grid.x <= radius_wild; grid.x++)
-        {
-            struct wild_type *w_ptr = get_wt_info_at(&grid);
+        struct chunk *c = chunk_list_at(i);
 
-            for (i = 0; i <= w_ptr->max_depth - w_ptr->min_depth; i++)
-            {
-                struct chunk *c = w_ptr->chunk_list[i];
-
-                if (c) process_monsters(c, true);
-            }
-        }
+        if (c) process_monsters(c, true);
     }
 
     /* Check for death */
@@ -2857,30 +2873,21 @@ static void process_worn(struct player *p, struct object *ring)
 static void post_turn_game_loop(void)
 {
     int i;
-    struct loc grid;
 
     /* Check for death */
     process_death();
 
     /* Process the rest of the monsters */
-    for (grid.y = radius_wild; grid.y >= 0 - radius_wild; grid.y--)
+    for (i = 0; i < chunk_list_max(); i++)
     {
-        for (grid.x = 0 - radius_wild; grid.x <= radius_wild; grid.x++)
-        {
-            struct wild_type *w_ptr = get_wt_info_at(&grid);
+        struct chunk *c = chunk_list_at(i);
 
-            for (i = 0; i <= w_ptr->max_depth - w_ptr->min_depth; i++)
-            {
-                struct chunk *c = w_ptr->chunk_list[i];
-
-                if (c)
-                {
-                    process_monsters(c, false);
+        if (c)
+        {
+            process_monsters(c, false);
 
-                    /* Mark all monsters as ready to act when they have the energy */
-                    reset_monsters(c);
-                }
-            }
+            /* Mark all monsters as ready to act when they have the energy */
+            reset_monsters(c);
         }
     }
 
@@ -2888,36 +2895,20 @@ static void post_turn_game_loop(void)
     process_death();
 
     /* Process the objects */
-    for (grid.y = radius_wild; grid.y >= 0 - radius_wild; grid.y--)
+    for (i = 0; i < chunk_list_max(); i++)
     {
-        for (grid.x = 0 - radius_wild; grid.x <= radius_wild; grid.x++)
-        {
-            struct wild_type *w_ptr = get_wt_info_at(&grid);
-
-            for (i = 0; i <= w_ptr->max_depth - w_ptr->min_depth; i++)
-            {
-                struct chunk *c = w_ptr->chunk_list[i];
+        struct chunk *c = chunk_list_at(i);
 
-                if (c) process_objects(c);
-            }
-        }
+        if (c) process_objects(c);
     }
 
     /* Process the world */
-    for (grid.y = radius_wild; grid.y >= 0 - radius_wild; grid.y--)
+    for (i = 0; i < chunk_list_max(); i++)
     {
-        for (grid.x = 0 - radius_wild; grid.x <= radius_wild; grid.x++)
-        {
-            struct wild_type *w_ptr = get_wt_info_at(&grid);
+        struct chunk *c = chunk_list_at(i);
 
-            for (i = 0; i <= w_ptr->max_depth - w_ptr->min_depth; i++)
-            {
-                struct chunk *c = w_ptr->chunk_list[i];
-
-                /* Process the world every ten turns */
-                if (c && !(turn.turn % 10)) process_world(NULL, c);
-            }
-        }
+        /* Process the world every ten turns */
+        if (c && !(turn.turn % 10)) process_world(NULL, c);
     }
 
     /* Process the world */
@@ -2933,6 +2924,9 @@ static void post_turn_game_loop(void)
     /* Process everything else */
     process_various();
 
+    /* Recompute the time bubbles now that everybody has acted */
+    reset_time_bubbles();
+
     /* Give energy to all players */
     for (i = 1; i <= NumPlayers; i++)
     {
@@ -2943,19 +2937,11 @@ static void post_turn_game_loop(void)
     }
 
     /* Give energy to all monsters */
-    for (grid.y = radius_wild; grid.y >= 0 - radius_wild; grid.y--)
+    for (i = 0; i < chunk_list_max(); i++)
     {
-        for (grid.x = 0 - radius_wild; grid.x <= radius_wild; grid.x++)
-        {
-            struct wild_type *w_ptr = get_wt_info_at(&grid);
+        struct chunk *c = chunk_list_at(i);
 
-            for (i = 0; i <= w_ptr->max_depth - w_ptr->min_depth; i++)
-            {
-                struct chunk *c = w_ptr->chunk_list[i];
-
-                if (c) energize_monsters(c);
-            }
-        }
+        if (c) energize_monsters(c);
     }
 
     /* Count game turns */
@@ -3188,6 +3174,12 @@ void run_game_loop(void)
 {
     int i;
 
+    /* Squeeze out the levels deallocated during the last turn */
+    chunk_list_compact();
+
+    /* Time bubbles are computed at most once per turn */
+    reset_time_bubbles();
+
     /* HIGHLY EXPERIMENTAL: turn-based mode (for single player games) */
     if (TURN_BASED && process_turn_based())
     {
@@ -3281,6 +3273,19 @@ bool level_keep_allocated(struct chunk *c)
 }
 
 
+/*
+ * Return true if the level is saved in its own savefile instead of the server savefile.
+ *
+ * Such levels can be swapped out to disk when nobody is on them. Special levels, towns and
+ * levels with houses are looked up from everywhere, so they always stay in memory.
+ */
+bool level_saved_apart(struct worldpos *wpos)
+{
+    if (special_level(wpos) || in_town(wpos)) return false;
+    return !level_has_any_houses(wpos);
+}
+
+
 #ifndef WINDOWS
 static void signals_ignore_tstp(void);
 static void signals_handle_tstp(void);
@@ -3519,6 +3524,9 @@ void shutdown_server(void)
     /* Stop the main loop */
     remove_timer_tick();
 
+    /* Dump the traffic statistics while the players are still connected */
+    dump_packet_stats();
+
     /* Kick every player out and save his game */
     while (NumPlayers > 0)
     {
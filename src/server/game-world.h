@@ -8,6 +8,7 @@
 
 #define SERVER_SAVE     10      /* Minutes between server saves */
 #define SERVER_PURGE    24      /* Hours between server purges */
+#define LEVEL_SWAP_OUT  15      /* Minutes before an empty static level is swapped out */
 #define GROW_CROPS      5000    /* How often to grow a bunch of new vegetables in wilderness */
 #define GROW_TREE       5000    /* How often to grow a new tree in towns */
 
@@ -36,6 +37,7 @@ extern int frame_energy(int speed);
 extern void run_game_loop(void);
 extern void kingly(struct player *p);
 extern bool level_keep_allocated(struct chunk *c);
+extern bool level_saved_apart(struct worldpos *wpos);
 extern void play_game(void);
 extern void shutdown_server(void);
 extern void exit_game_panic(void);
@@ -5505,7 +5505,7 @@ struct chunk *hard_centre_gen(struct player *p, struct worldpos *wpos, int min_h
 struct chunk *lair_gen(struct player *p, struct worldpos *wpos, int min_height, int min_width,
     const char **p_error)
 {
-    int i, k, y, x, n;
+    int i, k, n;
     int size_percent, y_size, x_size;
     int lake_size = 0;
     struct chunk *c;
@@ -5577,17 +5577,8 @@ struct chunk *lair_gen(struct player *p, struct worldpos *wpos, int min_height,
         pick_and_place_distant_monster(p, c, 0, MON_ASLEEP);
 
     /* PWMAngband: resize the main chunk */
-    for (y = 0; y < y_size; y++)
-    {
-        c->squares[y] = mem_realloc(c->squares[y], x_size * sizeof(struct square));
-        for (x = x_size / 2; x < x_size; x++)
-        {
-            memset(&c->squares[y][x], 0, sizeof(struct square));
-            c->squares[y][x].info = mem_zalloc(SQUARE_SIZE * sizeof(bitflag));
-        }
-    }
+    cave_set_width(c, x_size);
     player_cave_new(p, y_size, x_size);
-    c->width = x_size;
 
     /* Make the level */
     chunk_copy(c, lair, 0, x_size / 2);
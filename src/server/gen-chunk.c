@@ -38,6 +38,20 @@ static int chunk_index(struct wild_type *w_ptr, int depth)
 }
 
 
+/*
+ * Compact list of all the allocated chunks.
+ *
+ * The per-frame passes iterate over this instead of every depth slot of every
+ * wilderness location. Removing a chunk only leaves a hole in the list, so a
+ * pass stays valid if a level is deallocated while it runs; the holes are
+ * squeezed out by chunk_list_compact() between two game turns.
+ */
+static struct chunk **chunk_active = NULL;
+static int chunk_active_max = 0;
+static int chunk_active_size = 0;
+static bool chunk_active_holes = false;
+
+
 /*
  * Add an entry to the chunk list.
  *
@@ -46,8 +60,34 @@ static int chunk_index(struct wild_type *w_ptr, int depth)
 void chunk_list_add(struct chunk *c)
 {
     struct wild_type *w_ptr = get_wt_info_at(&c->wpos.grid);
+    int idx = chunk_index(w_ptr, c->wpos.depth);
+
+    int i;
 
-    w_ptr->chunk_list[chunk_index(w_ptr, c->wpos.depth)] = c;
+    /* Already there */
+    if (w_ptr->chunk_list[idx] == c) return;
+
+    /* Replace the old level */
+    if (w_ptr->chunk_list[idx]) chunk_list_remove(w_ptr->chunk_list[idx]);
+
+    w_ptr->chunk_list[idx] = c;
+
+    /* Players already there are now on the level */
+    for (i = 1; i <= NumPlayers; i++)
+    {
+        struct player *p = player_get(i);
+
+        if (wpos_eq(&p->wpos, &c->wpos)) chunk_roster_add(p);
+    }
+
+    /* Append to the list of allocated chunks */
+    if (chunk_active_max == chunk_active_size)
+    {
+        chunk_active_size = (chunk_active_size? 2 * chunk_active_size: 64);
+        chunk_active = mem_realloc(chunk_active, chunk_active_size * sizeof(struct chunk *));
+    }
+    c->chunk_idx = chunk_active_max;
+    chunk_active[chunk_active_max++] = c;
 }
 
 
@@ -61,6 +101,120 @@ void chunk_list_remove(struct chunk *c)
     struct wild_type *w_ptr = get_wt_info_at(&c->wpos.grid);
 
     w_ptr->chunk_list[chunk_index(w_ptr, c->wpos.depth)] = NULL;
+
+    /* Empty the player roster */
+    while (c->players) chunk_roster_remove(c->players);
+
+    /* Leave a hole in the list of allocated chunks */
+    if ((c->chunk_idx >= 0) && (c->chunk_idx < chunk_active_max) &&
+        (chunk_active[c->chunk_idx] == c))
+    {
+        chunk_active[c->chunk_idx] = NULL;
+        chunk_active_holes = true;
+    }
+    c->chunk_idx = -1;
+}
+
+
+/*
+ * Squeeze the holes out of the list of allocated chunks, keeping the order.
+ *
+ * Must not be called while iterating over the list.
+ */
+void chunk_list_compact(void)
+{
+    int i, n = 0;
+
+    if (!chunk_active_holes) return;
+
+    for (i = 0; i < chunk_active_max; i++)
+    {
+        struct chunk *c = chunk_active[i];
+
+        if (!c) continue;
+        c->chunk_idx = n;
+        chunk_active[n++] = c;
+    }
+    chunk_active_max = n;
+    chunk_active_holes = false;
+}
+
+
+/*
+ * Number of slots in the list of allocated chunks (including holes).
+ */
+int chunk_list_max(void)
+{
+    return chunk_active_max;
+}
+
+
+/*
+ * Get a slot from the list of allocated chunks (NULL for a hole).
+ */
+struct chunk *chunk_list_at(int idx)
+{
+    my_assert((idx >= 0) && (idx < chunk_active_max));
+
+    return chunk_active[idx];
+}
+
+
+/*
+ * Free the list of allocated chunks.
+ */
+void chunk_list_free(void)
+{
+    mem_free(chunk_active);
+    chunk_active = NULL;
+    chunk_active_max = 0;
+    chunk_active_size = 0;
+    chunk_active_holes = false;
+}
+
+
+/*
+ * Put a player on the roster of the level he is on, if it is allocated.
+ *
+ * Each chunk keeps an intrusive list of the players on it, so that the
+ * per-level passes don't have to scan every player on the server.
+ */
+void chunk_roster_add(struct player *p)
+{
+    struct chunk *c = chunk_get(&p->wpos);
+
+    /* Already there */
+    if (p->roster_chunk == c) return;
+
+    /* Leave the previous level */
+    chunk_roster_remove(p);
+
+    if (!c) return;
+
+    p->roster_chunk = c;
+    p->roster_prev = NULL;
+    p->roster_next = c->players;
+    if (c->players) c->players->roster_prev = p;
+    c->players = p;
+}
+
+
+/*
+ * Take a player off the roster of his level.
+ */
+void chunk_roster_remove(struct player *p)
+{
+    struct chunk *c = p->roster_chunk;
+
+    if (!c) return;
+
+    if (p->roster_prev) p->roster_prev->roster_next = p->roster_next;
+    else c->players = p->roster_next;
+    if (p->roster_next) p->roster_next->roster_prev = p->roster_prev;
+
+    p->roster_chunk = NULL;
+    p->roster_prev = NULL;
+    p->roster_next = NULL;
 }
 
 
@@ -133,12 +287,27 @@ bool chunk_inhibit_players(struct worldpos *wpos)
 }
 
 
+/*
+ * Players coming and going change what is saved for the level
+ */
+static void chunk_count_changed(struct worldpos *wpos)
+{
+    struct chunk *c = chunk_get(wpos);
+
+    if (c) c->modified = true;
+
+    /* Nobody is left on a level swapped out to disk: get rid of it */
+    else if (!chunk_has_players(wpos) && chunk_on_disk(wpos)) forget_level(wpos);
+}
+
+
 void chunk_decrease_player_count(struct worldpos *wpos)
 {
     struct wild_type *w_ptr = get_wt_info_at(&wpos->grid);
     int index = players_on_depth_index(w_ptr, wpos->depth);
 
     if (w_ptr->players_on_depth[index]) w_ptr->players_on_depth[index]--;
+    chunk_count_changed(wpos);
 }
 
 
@@ -147,6 +316,7 @@ void chunk_set_player_count(struct worldpos *wpos, int16_t value)
     struct wild_type *w_ptr = get_wt_info_at(&wpos->grid);
 
     w_ptr->players_on_depth[players_on_depth_index(w_ptr, wpos->depth)] = value;
+    chunk_count_changed(wpos);
 }
 
 
@@ -155,6 +325,7 @@ void chunk_increase_player_count(struct worldpos *wpos)
     struct wild_type *w_ptr = get_wt_info_at(&wpos->grid);
 
     w_ptr->players_on_depth[players_on_depth_index(w_ptr, wpos->depth)]++;
+    chunk_count_changed(wpos);
 }
 
 
@@ -173,3 +344,23 @@ int16_t chunk_get_player_count(struct worldpos *wpos)
 
     return w_ptr->players_on_depth[players_on_depth_index(w_ptr, wpos->depth)];
 }
+
+
+/*
+ * Levels swapped out to their own savefile are not in the chunk list until
+ * a player enters them again
+ */
+bool chunk_on_disk(struct worldpos *wpos)
+{
+    struct wild_type *w_ptr = get_wt_info_at(&wpos->grid);
+
+    return w_ptr->on_disk[players_on_depth_index(w_ptr, wpos->depth)];
+}
+
+
+void chunk_set_on_disk(struct worldpos *wpos, bool value)
+{
+    struct wild_type *w_ptr = get_wt_info_at(&wpos->grid);
+
+    w_ptr->on_disk[players_on_depth_index(w_ptr, wpos->depth)] = value;
+}
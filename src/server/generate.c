@@ -1233,6 +1233,50 @@ void cave_wipe(struct chunk *c)
             track_object(p->upkeep, NULL);
     }
 
+    /* The level is gone for good, and so is its savefile */
+    delete_level(&c->wpos);
+
+    /* Free the chunk */
+    cave_free(c);
+}
+
+
+/*
+ * Free a level that was just swapped out to its own savefile.
+ *
+ * Unlike cave_wipe, the uniques and artifacts on the level still exist: they
+ * come back with the level.
+ */
+void cave_release(struct chunk *c)
+{
+    int i;
+
+    /* Free the monsters and what they carry */
+    for (i = 1; i < cave_monster_max(c); i++)
+    {
+        struct monster *mon = cave_monster(c, i);
+
+        if (!mon->race) continue;
+
+        object_pile_free(mon->held_obj);
+        mem_free(mon->blow);
+    }
+
+    /* Free the monster groups */
+    for (i = 1; i < z_info->level_monster_max; i++)
+    {
+        if (c->monster_groups[i]) monster_group_free(c->monster_groups[i]);
+    }
+
+    /* Cancel tracking for all players */
+    for (i = 1; i <= NumPlayers; i++)
+    {
+        struct player *p = player_get(i);
+
+        if (p->upkeep && p->upkeep->object && !object_is_carried(p, p->upkeep->object))
+            track_object(p->upkeep, NULL);
+    }
+
     /* Free the chunk */
     cave_free(c);
 }
@@ -1445,6 +1489,9 @@ static void check_level_size(struct worldpos *wpos, int n, int *min_height, int
     {
         struct chunk *c = chunk_get(&check);
 
+        /* A level swapped out to disk still counts */
+        if (!c) c = load_level(&check);
+
         if (c)
         {
             *min_height = MAX(*min_height, c->height);
@@ -316,6 +316,12 @@ extern struct chunk *arena_gen(struct player *p, struct worldpos *wpos, int min_
 /* gen-chunk.c */
 extern void chunk_list_add(struct chunk *c);
 extern void chunk_list_remove(struct chunk *c);
+extern void chunk_roster_add(struct player *p);
+extern void chunk_roster_remove(struct player *p);
+extern void chunk_list_compact(void);
+extern int chunk_list_max(void);
+extern struct chunk *chunk_list_at(int idx);
+extern void chunk_list_free(void);
 extern void chunk_validate_objects(struct chunk *c);
 extern struct chunk *chunk_get(struct worldpos *wpos);
 extern bool chunk_inhibit_players(struct worldpos *wpos);
@@ -324,6 +330,8 @@ extern void chunk_set_player_count(struct worldpos *wpos, int16_t value);
 extern void chunk_increase_player_count(struct worldpos *wpos);
 extern bool chunk_has_players(struct worldpos *wpos);
 extern int16_t chunk_get_player_count(struct worldpos *wpos);
+extern bool chunk_on_disk(struct worldpos *wpos);
+extern void chunk_set_on_disk(struct worldpos *wpos, bool value);
 
 /* gen-monster.c */
 extern bool mon_restrict(const char *monster_type, int depth, int current_depth, bool unique_ok);
@@ -419,6 +427,7 @@ extern bool alloc_object(struct player *p, struct chunk *c, int set, int typ, in
 
 /* generate.c */
 extern void cave_wipe(struct chunk *c);
+extern void cave_release(struct chunk *c);
 extern bool allow_location(struct monster_race *race, struct worldpos *wpos);
 extern struct chunk *prepare_next_level(struct player *p);
 extern void player_place_feeling(struct player *p, struct chunk *c);
@@ -710,6 +710,7 @@ void know_houses(struct player *p)
                 object_notice_everything(p, obj);
         }
         while (loc_iterator_next(&iter));
+        c->modified = true;
     }
 }
 
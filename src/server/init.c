@@ -54,7 +54,13 @@ bool cfg_limit_player_connections = true;
 int32_t cfg_tcp_port = 18346;
 int16_t cfg_quit_timeout = 5;
 uint32_t cfg_disconnect_fainting = 180;
+int32_t cfg_output_high_water = 1024;
+int32_t cfg_output_low_water = 256;
+int16_t cfg_output_stall_timeout = 30;
 bool cfg_lazy_connections = false;
+bool cfg_compress_setup = true;
+bool cfg_net_thread = true;
+char *cfg_packet_stats_file = NULL;
 bool cfg_chardump_color = false;
 int16_t cfg_pvp_hostility = PVP_SAFE;
 bool cfg_base_monsters = true;
@@ -4762,6 +4768,7 @@ static struct init_module arrays_module =
 
 extern struct init_module z_quark_module;
 extern struct init_module generate_module;
+extern struct init_module view_module;
 extern struct init_module rune_module;
 extern struct init_module mon_make_module;
 extern struct init_module obj_make_module;
@@ -4775,6 +4782,7 @@ static struct init_module *modules[] =
     &z_quark_module,
     &ui_visuals_module, /* This needs to load before monsters and objects. */
     &arrays_module,
+    &view_module,
     &generate_module,
     &rune_module,
     &mon_make_module,
@@ -4877,6 +4885,8 @@ static void unload_server_cfg(void)
     cfg_load_pref_file = NULL;
     string_free(cfg_chardump_label);
     cfg_chardump_label = NULL;
+    string_free(cfg_packet_stats_file);
+    cfg_packet_stats_file = NULL;
 }
 
 
@@ -4895,6 +4905,9 @@ void cleanup_angband(void)
     /* Stop the main loop */
     remove_timer_tick();
 
+    /* Let the background saves land */
+    autosave_stop();
+
     /* Free wilderness info */
     free_wild_info();
 
@@ -5034,8 +5047,40 @@ static void set_server_option(const char *option, char *value)
     }
     else if (streq(option, "DISCONNECT_FAINTING"))
         cfg_disconnect_fainting = atoi(value);
+    else if (streq(option, "OUTPUT_HIGH_WATER"))
+    {
+        cfg_output_high_water = atoi(value);
+
+        /* Sanity checks */
+        if (cfg_output_high_water < 128) cfg_output_high_water = 128;
+        if (cfg_output_high_water > 65536) cfg_output_high_water = 65536;
+    }
+    else if (streq(option, "OUTPUT_LOW_WATER"))
+    {
+        cfg_output_low_water = atoi(value);
+
+        /* Sanity checks */
+        if (cfg_output_low_water < 0) cfg_output_low_water = 0;
+    }
+    else if (streq(option, "OUTPUT_STALL_TIMEOUT"))
+    {
+        cfg_output_stall_timeout = atoi(value);
+
+        /* Sanity checks */
+        if (cfg_output_stall_timeout < 1) cfg_output_stall_timeout = 1;
+        if (cfg_output_stall_timeout > 300) cfg_output_stall_timeout = 300;
+    }
     else if (streq(option, "LAZY_CONNECTIONS"))
         cfg_lazy_connections = str_to_boolean(value);
+    else if (streq(option, "COMPRESS_SETUP"))
+        cfg_compress_setup = str_to_boolean(value);
+    else if (streq(option, "NET_THREAD"))
+        cfg_net_thread = str_to_boolean(value);
+    else if (streq(option, "PACKET_STATS_FILE"))
+    {
+        string_free(cfg_packet_stats_file);
+        cfg_packet_stats_file = string_make(value);
+    }
     else if (streq(option, "CHARACTER_DUMP_COLOR"))
         cfg_chardump_color = str_to_boolean(value);
     else if (streq(option, "PVP_HOSTILITY"))
@@ -34,7 +34,13 @@ extern bool cfg_limit_player_connections;
 extern int32_t cfg_tcp_port;
 extern int16_t cfg_quit_timeout;
 extern uint32_t cfg_disconnect_fainting;
+extern int32_t cfg_output_high_water;
+extern int32_t cfg_output_low_water;
+extern int16_t cfg_output_stall_timeout;
 extern bool cfg_lazy_connections;
+extern bool cfg_compress_setup;
+extern bool cfg_net_thread;
+extern char *cfg_packet_stats_file;
 extern bool cfg_chardump_color;
 extern int16_t cfg_pvp_hostility;
 extern bool cfg_base_monsters;
@@ -1826,6 +1826,39 @@ int rd_traps(struct player *unused)
 }
 
 
+/*
+ * Read the player count of the static levels saved in their own file
+ *
+ * These levels are only loaded when a player enters them.
+ */
+int rd_levels(struct player *unused)
+{
+    uint32_t i, tmp32u;
+
+    /* Read the number of levels */
+    rd_u32b(&tmp32u);
+
+    /* Read the levels */
+    for (i = 0; i < tmp32u; i++)
+    {
+        struct worldpos wpos;
+        int16_t tmp16s, tmp16x, tmp16y;
+
+        rd_s16b(&tmp16y);
+        rd_s16b(&tmp16x);
+        loc_init(&wpos.grid, tmp16x, tmp16y);
+        rd_s16b(&wpos.depth);
+        rd_s16b(&tmp16s);
+
+        chunk_set_player_count(&wpos, tmp16s);
+        if (!chunk_get(&wpos)) chunk_set_on_disk(&wpos, true);
+    }
+
+    /* Success */
+    return (0);
+}
+
+
 int rd_history(struct player *p)
 {
     int16_t tmp16s;
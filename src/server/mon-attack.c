@@ -530,6 +530,7 @@ bool make_ranged_attack(struct source *who, struct chunk *c, struct monster *mon
 
     /* Record any new info */
     lore_update(mon->race, lore);
+    who->player->upkeep->dirty = true;
 
     // Slash effect
     slash_fx(mon, who);
@@ -968,6 +969,7 @@ bool make_attack_normal(struct monster *mon, struct source *who)
 
     /* Learn lore */
     lore_update(mon->race, lore);
+    who->player->upkeep->dirty = true;
 
     // Slash effect
     slash_fx(mon, who);
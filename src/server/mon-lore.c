@@ -384,6 +384,7 @@ void lore_do_probe(struct player *p, struct monster *mon)
     /* Full knowledge */
     lore->all_known = true;
     lore_update(mon->race, lore);
+    p->upkeep->dirty = true;
 
     /* Update monster recall window */
     if (ACTOR_RACE_EQUAL(monster_race, mon)) p->upkeep->redraw |= (PR_MONSTER);
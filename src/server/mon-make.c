@@ -544,6 +544,7 @@ static bool clear_vis(struct player *p, struct worldpos *wpos, int m)
     if (!wpos_eq(&p->wpos, wpos)) return false;
 
     /* Clear some fields */
+    if (mflag_has(p->mflag[m], MFLAG_THREAT)) p->threats_in_view--;
     mflag_wipe(p->mflag[m]);
     p->mon_det[m] = 0;
 
@@ -729,6 +730,9 @@ static void monster_index_move(struct chunk *c, int i1, int i2)
         if (!wpos_eq(&p->wpos, &c->wpos)) continue;
 
         mflag_copy(p->mflag[i2], p->mflag[i1]);
+
+        /* The threat moved with the monster */
+        mflag_off(p->mflag[i1], MFLAG_THREAT);
         p->mon_det[i2] = p->mon_det[i1];
 
         /* Update the target */
@@ -2712,6 +2712,7 @@ static void monster_reduce_sleep(struct monster *mon, bool mvm)
             if (!woke_up && (lore->ignore < UCHAR_MAX)) lore->ignore++;
             else if (woke_up && (lore->wake < UCHAR_MAX)) lore->wake++;
             lore_update(mon->race, lore);
+            p->upkeep->dirty = true;
         }
     }
 
@@ -2867,19 +2868,15 @@ static void regen_monster(struct monster *mon)
 static void get_closest_player(struct chunk *c, struct monster *mon)
 {
     int i;
-    struct player *closest = NULL;
+    struct player *p, *closest = NULL;
     int dis_to_closest = 9999, lowhp = 9999;
     bool blos = false, new_los;
 
-    /* Check for each player */
-    for (i = 1; i <= NumPlayers; i++)
+    /* Check for each player on the level */
+    for (p = c->players; p; p = p->roster_next)
     {
-        struct player *p = player_get(i);
         int d;
 
-        /* Make sure he's on the same dungeon level */
-        if (!wpos_eq(&p->wpos, &mon->wpos)) continue;
-
         /* Skip him if he's shopping */
         if (in_store(p)) continue;
 
@@ -2919,7 +2916,7 @@ static void get_closest_player(struct chunk *c, struct monster *mon)
     /* Controlled monsters without a target will always try to reach their master */
     if ((mon->status == MSTATUS_CONTROLLED) && !closest)
     {
-        struct player *p = player_from_id(mon->master);
+        p = player_from_id(mon->master);
 
         if (p)
         {
@@ -2958,7 +2955,8 @@ static void get_closest_player(struct chunk *c, struct monster *mon)
  */
 void process_monsters(struct chunk *c, bool more_energy)
 {
-    int i, j, time;
+    int i, time;
+    struct player *q;
 
     /* Only process some things every so often */
     bool regen;
@@ -2982,13 +2980,11 @@ void process_monsters(struct chunk *c, bool more_energy)
         // Necro, tamer etc class pets routine
         if (mon->master)
         {
-            for (j = 1; j <= NumPlayers; j++)
-            {
-                // use 'b' instead of 'p' there (also other dev used 'q' in code below)
-                struct player *b = player_get(j);
-
-                if (b->id != mon->master) continue;
+            // use 'b' instead of 'p' there (also other dev used 'q' in code below)
+            struct player *b = player_from_id(mon->master);
 
+            if (b)
+            {
                 // Class spell to unsummon pets (necromancer, assassin, tamer)
                 if (b->timed[TMD_UNSUMMON_MINIONS])
                 {
@@ -3104,12 +3100,7 @@ void process_monsters(struct chunk *c, bool more_energy)
     /* Every 5 game turns */
     if (turn.turn % 5) return;
 
-    for (j = 1; j <= NumPlayers; j++)
-    {
-        struct player *q = player_get(j);
-
-        q->did_flicker = false;
-    }
+    for (q = c->players; q; q = q->roster_next) q->did_flicker = false;
 
     /* Shimmer multi-hued monsters */
     for (i = 1; i < cave_monster_max(c); i++)
@@ -3119,23 +3110,16 @@ void process_monsters(struct chunk *c, bool more_energy)
         if (!mon->race) continue;
         if (!monster_shimmer(mon->race)) continue;
 
-        /* Check everyone */
-        for (j = 1; j <= NumPlayers; j++)
+        /* Check everyone on the level */
+        for (q = c->players; q; q = q->roster_next)
         {
-            struct player *q = player_get(j);
-
-            /* If he's not here, skip him */
-            if (!wpos_eq(&q->wpos, &mon->wpos)) continue;
-
             /* Actually light that spot for that player */
             if (monster_allow_shimmer(q)) square_light_spot_aux(q, c, &mon->grid);
         }
     }
 
-    for (j = 1; j <= NumPlayers; j++)
+    for (q = c->players; q; q = q->roster_next)
     {
-        struct player *q = player_get(j);
-
         if (q->did_flicker)
         {
             if (q->flicker == 255) q->flicker = 0;
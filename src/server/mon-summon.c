@@ -566,6 +566,7 @@ int summon_specific(struct player *p, struct chunk *c, struct loc *grid, int lev
         {
             /* Set timer directly to avoid resistance */
             mon->m_timed[MON_TMD_HOLD] = MIN(turns, 32767);
+            update_mon_threats(mon);
         }
     }
 
@@ -239,6 +239,13 @@ static bool mon_set_timed(struct player *p, struct monster *mon, int effect_type
 
         /* Update the visuals, as appropriate. */
         if ((effect_type == MON_TMD_SLEEP) || (effect_type == MON_TMD_CHANGED)) update_monlist(mon);
+
+        /* Sleeping, held and shapechanged monsters may (no longer) be threats */
+        if ((((effect_type == MON_TMD_SLEEP) || (effect_type == MON_TMD_HOLD)) &&
+            (!old_timer != !mon->m_timed[effect_type])) || (effect_type == MON_TMD_CHANGED))
+        {
+            update_mon_threats(mon);
+        }
     }
 
     return !resisted;
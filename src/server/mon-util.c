@@ -527,6 +527,96 @@ static void update_mon_aux(struct player *p, struct monster *mon, struct chunk *
             p->upkeep->redraw |= (PR_MONLIST);
         }
     }
+
+    /* Count hostile monsters in view */
+    update_mon_threat(p, mon);
+}
+
+
+/*
+ * Check if a monster is a threat in view for monsters_in_los(): in view, hostile,
+ * not hidden and not incapacitated.
+ */
+static bool monster_is_threat(struct player *p, struct monster *mon)
+{
+    if (!mon->race) return false;
+    if (!monster_is_in_view(p, mon->midx)) return false;
+
+    /* PWMAngband: don't count non hostile monsters */
+    if (!pvm_check(p, mon)) return false;
+
+    /* PWMAngband: skip if the monster is hidden */
+    if (monster_is_camouflaged(mon)) return false;
+
+    /* Skip incapacitated monsters */
+    if (mon->m_timed[MON_TMD_SLEEP] || mon->m_timed[MON_TMD_HOLD]) return false;
+
+    /* PWMAngband: if disturb_nomove isn't set, allow nonmovable monsters */
+    if (rf_has(mon->race->flags, RF_NEVER_MOVE) && !OPT(p, disturb_nomove)) return false;
+
+    return true;
+}
+
+
+/*
+ * Update the "threat in view" status of a monster for a player.
+ *
+ * Monsters which are threats are flagged MFLAG_THREAT and counted in
+ * p->threats_in_view, so that monsters_in_los() doesn't need to scan the level.
+ * This must be called whenever one of the conditions of monster_is_threat()
+ * changes.
+ */
+void update_mon_threat(struct player *p, struct monster *mon)
+{
+    bool threat = monster_is_threat(p, mon);
+
+    /* No change */
+    if (threat == mflag_has(p->mflag[mon->midx], MFLAG_THREAT)) return;
+
+    if (threat)
+    {
+        mflag_on(p->mflag[mon->midx], MFLAG_THREAT);
+        p->threats_in_view++;
+    }
+    else
+    {
+        mflag_off(p->mflag[mon->midx], MFLAG_THREAT);
+        p->threats_in_view--;
+    }
+}
+
+
+/*
+ * Update the "threat in view" status of a monster for all the players on its level.
+ */
+void update_mon_threats(struct monster *mon)
+{
+    int i;
+
+    for (i = 1; i <= NumPlayers; i++)
+    {
+        struct player *p = player_get(i);
+
+        /* Skip irrelevant players */
+        if (!wpos_eq(&p->wpos, &mon->wpos)) continue;
+        if (p->upkeep->new_level_method || p->upkeep->funeral) continue;
+        if (!p->placed) continue;
+
+        update_mon_threat(p, mon);
+    }
+}
+
+
+/*
+ * Forget all the threats in view (when changing level).
+ */
+void forget_mon_threats(struct player *p)
+{
+    int i;
+
+    for (i = 1; i < z_info->level_monster_max; i++)
+        mflag_off(p->mflag[i], MFLAG_THREAT);
+    p->threats_in_view = 0;
 }
 
 
@@ -697,6 +787,7 @@ void monster_swap(struct chunk *c, struct loc *grid1, struct loc *grid2)
         /* Move player */
         loc_copy(&p->grid, &to);
         player_leaving(p, c, &p->old_grid, &p->grid);
+        p->upkeep->dirty = true;
 
         /* Update the trap detection status */
         p->upkeep->redraw |= (PR_DTRAP);
@@ -742,6 +833,7 @@ void monster_swap(struct chunk *c, struct loc *grid1, struct loc *grid2)
         /* Move player */
         loc_copy(&p->grid, &from);
         player_leaving(p, c, &p->old_grid, &p->grid);
+        p->upkeep->dirty = true;
 
         /* Update the trap detection status */
         p->upkeep->redraw |= (PR_DTRAP);
@@ -806,6 +898,7 @@ void become_aware(struct player *p, struct chunk *c, struct monster *mon)
     if (!monster_is_camouflaged(mon)) return;
 
     mflag_off(mon->mflag, MFLAG_CAMOUFLAGE);
+    update_mon_threats(mon);
 
     /* Learn about mimicry */
     if (lore && rf_has(mon->race->flags, RF_UNAWARE)) rf_on(lore->flags, RF_UNAWARE);
@@ -26,6 +26,9 @@ extern void player_desc(struct player *p, char *desc, size_t max, struct player
     bool capitalize);
 extern void update_mon(struct monster *mon, struct chunk *c, bool full);
 extern void update_monsters(struct chunk *c, bool full);
+extern void update_mon_threat(struct player *p, struct monster *mon);
+extern void update_mon_threats(struct monster *mon);
+extern void forget_mon_threats(struct player *p);
 extern bool monster_carry(struct monster *mon, struct object *obj, bool force);
 extern void monster_swap(struct chunk *c, struct loc *grid1, struct loc *grid2);
 extern void monster_wake(struct player *p, struct monster *mon, bool notify, int aware_chance);
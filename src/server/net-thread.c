@@ -0,0 +1,609 @@
+/*
+ * File: net-thread.c
+ * Purpose: Network I/O thread for player connections
+ *
+ * Copyright (c) 2025 MAngband and PWMAngband Developers
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+
+#define SERVER
+
+#include "s-angband.h"
+
+#ifdef USE_NET_THREAD
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+
+/*
+ * The network thread does the socket I/O of the player connections: it reads
+ * what the clients send into an inbound ring, and writes to the sockets what
+ * the game thread put in an outbound ring. Each ring has a single producer
+ * and a single consumer, so it needs no lock: each side only moves its own
+ * index, and publishes it with release/acquire ordering.
+ *
+ * Each side wakes the other through a pipe, but only if the other side is
+ * not already due to look (a flag that goes from 0 to 1), so a burst of
+ * packets costs a single wakeup.
+ *
+ * The network thread holds a lock while it handles events. Attaching and
+ * detaching a connection take the same lock, so once net_thread_detach()
+ * returns, the game thread owns the socket again and can close it.
+ */
+#define NET_RING_SIZE   65536   /* Must be a power of two */
+#define NET_RING_MASK   (NET_RING_SIZE - 1)
+#define NET_MAX_EVENTS  256
+#define NET_WAKEUP      ((uint64_t)-1)
+
+
+struct net_ring
+{
+    char *data;
+    uint32_t head;          /* Read position, only moved by the consumer */
+    uint32_t tail;          /* Write position, only moved by the producer */
+};
+
+
+struct net_slot
+{
+    int fd;
+    uint32_t gen;           /* Bumped on detach, so stale events are ignored */
+    bool active;            /* Attached (changed under the lock) */
+    uint32_t events;        /* Events registered with epoll */
+    struct net_ring in;     /* Network thread -> game thread */
+    struct net_ring out;    /* Game thread -> network thread */
+    int in_full;            /* The network thread stopped reading */
+    int status;             /* NET_OK, NET_CLOSED or NET_BROKEN */
+    uint32_t drain_mark;    /* Outbound read position last seen by the game */
+};
+
+
+static struct net_slot *slots;
+static pthread_t net_thread;
+static pthread_mutex_t net_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool net_running;
+static int net_stop;
+static int epoll_fd = -1;
+static int net_wake[2] = {-1, -1};      /* Game thread -> network thread */
+static int game_wake[2] = {-1, -1};     /* Network thread -> game thread */
+static int net_armed;
+static int game_armed;
+static void (*game_func)(void);
+
+
+/*** Rings ***/
+
+
+static uint32_t ring_used(struct net_ring *ring)
+{
+    return __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) -
+        __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+}
+
+
+/*
+ * Describe "len" bytes of the ring starting at "pos" as (at most) two
+ * contiguous segments.
+ */
+static int ring_segments(struct net_ring *ring, uint32_t pos, uint32_t len, struct iovec *iov)
+{
+    uint32_t off = pos & NET_RING_MASK;
+    uint32_t first = MIN(len, NET_RING_SIZE - off);
+
+    iov[0].iov_base = ring->data + off;
+    iov[0].iov_len = first;
+    if (first == len) return 1;
+    iov[1].iov_base = ring->data;
+    iov[1].iov_len = len - first;
+
+    return 2;
+}
+
+
+static void ring_produced(struct net_ring *ring, uint32_t len)
+{
+    __atomic_store_n(&ring->tail, ring->tail + len, __ATOMIC_RELEASE);
+}
+
+
+static void ring_consumed(struct net_ring *ring, uint32_t len)
+{
+    __atomic_store_n(&ring->head, ring->head + len, __ATOMIC_RELEASE);
+}
+
+
+/*** Wakeups ***/
+
+
+static void pipe_poke(int fd)
+{
+    char c = 0;
+
+    while ((write(fd, &c, 1) < 0) && (errno == EINTR)) ;
+}
+
+
+static void pipe_drain(int fd)
+{
+    char buf[64];
+    ssize_t n;
+
+    while (((n = read(fd, buf, sizeof(buf))) > 0) || ((n < 0) && (errno == EINTR))) ;
+}
+
+
+static void wake_net(void)
+{
+    if (!__atomic_exchange_n(&net_armed, 1, __ATOMIC_SEQ_CST)) pipe_poke(net_wake[1]);
+}
+
+
+static void wake_game(void)
+{
+    if (!__atomic_exchange_n(&game_armed, 1, __ATOMIC_SEQ_CST)) pipe_poke(game_wake[1]);
+}
+
+
+/*** Network thread ***/
+
+
+/*
+ * Change the events we wait for on a connection (0 to stop watching it).
+ */
+static bool slot_watch(struct net_slot *slot, uint32_t events)
+{
+    struct epoll_event ev;
+    int op;
+
+    if (events == slot->events) return true;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.u64 = ((uint64_t)slot->gen << 32) | (uint32_t)(slot - slots);
+
+    if (!events) op = EPOLL_CTL_DEL;
+    else if (!slot->events) op = EPOLL_CTL_ADD;
+    else op = EPOLL_CTL_MOD;
+
+    if (epoll_ctl(epoll_fd, op, slot->fd, &ev) == -1) return false;
+    slot->events = events;
+
+    return true;
+}
+
+
+/*
+ * Give up on a connection and let the game thread deal with it.
+ */
+static void slot_fail(struct net_slot *slot, int status)
+{
+    slot_watch(slot, 0);
+    __atomic_store_n(&slot->status, status, __ATOMIC_RELEASE);
+    wake_game();
+}
+
+
+static void slot_read(struct net_slot *slot)
+{
+    struct iovec iov[2];
+    uint32_t space = NET_RING_SIZE - ring_used(&slot->in);
+    ssize_t n;
+
+    if (!space)
+    {
+        /*
+         * The game thread is behind: stop reading until it catches up, unless
+         * it did so in the meantime (it will wake us up to read again)
+         */
+        __atomic_store_n(&slot->in_full, 1, __ATOMIC_SEQ_CST);
+        if (ring_used(&slot->in) == NET_RING_SIZE) slot_watch(slot, slot->events & ~EPOLLIN);
+        return;
+    }
+
+    while ((n = readv(slot->fd, iov, ring_segments(&slot->in, slot->in.tail, space, iov))) < 0)
+    {
+        if (errno == EINTR) continue;
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) return;
+        break;
+    }
+
+    /* The client closed the connection */
+    if (n <= 0)
+    {
+        slot_fail(slot, NET_CLOSED);
+        return;
+    }
+
+    ring_produced(&slot->in, (uint32_t)n);
+    wake_game();
+}
+
+
+static void slot_write(struct net_slot *slot)
+{
+    uint32_t used;
+
+    while ((used = ring_used(&slot->out)) > 0)
+    {
+        struct iovec iov[2];
+        ssize_t n;
+
+        while ((n = writev(slot->fd, iov, ring_segments(&slot->out, slot->out.head, used, iov))) < 0)
+        {
+            if (errno == EINTR) continue;
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) break;
+            slot_fail(slot, NET_BROKEN);
+            return;
+        }
+        if (n > 0) ring_consumed(&slot->out, (uint32_t)n);
+
+        /* The kernel is full: wait until the socket is writable */
+        if (n < (ssize_t)used)
+        {
+            slot_watch(slot, slot->events | EPOLLOUT);
+            return;
+        }
+    }
+
+    slot_watch(slot, slot->events & ~EPOLLOUT);
+}
+
+
+/*
+ * The game thread queued output or made room for input: have a look at all
+ * the connections.
+ */
+static void net_scan(void)
+{
+    int i;
+
+    __atomic_store_n(&net_armed, 0, __ATOMIC_SEQ_CST);
+
+    for (i = 0; i < MAX_PLAYERS; i++)
+    {
+        struct net_slot *slot = &slots[i];
+
+        if (!slot->active || __atomic_load_n(&slot->status, __ATOMIC_ACQUIRE)) continue;
+
+        if (!(slot->events & EPOLLIN) && !__atomic_load_n(&slot->in_full, __ATOMIC_SEQ_CST))
+            slot_watch(slot, slot->events | EPOLLIN);
+        if (!(slot->events & EPOLLOUT) && ring_used(&slot->out)) slot_write(slot);
+    }
+}
+
+
+static void *net_thread_main(void *arg)
+{
+    struct epoll_event events[NET_MAX_EVENTS];
+
+    while (!__atomic_load_n(&net_stop, __ATOMIC_ACQUIRE))
+    {
+        int i, n = epoll_wait(epoll_fd, events, NET_MAX_EVENTS, -1);
+        bool scan = false;
+
+        if (n < 0) continue;
+
+        pthread_mutex_lock(&net_lock);
+        for (i = 0; i < n; i++)
+        {
+            uint64_t data = events[i].data.u64;
+            struct net_slot *slot;
+
+            if (data == NET_WAKEUP)
+            {
+                pipe_drain(net_wake[0]);
+                scan = true;
+                continue;
+            }
+
+            /* Ignore connections that were detached since */
+            slot = &slots[(uint32_t)data];
+            if (!slot->active || (slot->gen != (uint32_t)(data >> 32))) continue;
+
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) slot_read(slot);
+            if ((events[i].events & EPOLLOUT) && !slot->status) slot_write(slot);
+        }
+        if (scan) net_scan();
+        pthread_mutex_unlock(&net_lock);
+    }
+
+    return NULL;
+}
+
+
+/*** Game thread ***/
+
+
+static void net_thread_ready(int fd, int arg)
+{
+    pipe_drain(fd);
+    __atomic_store_n(&game_armed, 0, __ATOMIC_SEQ_CST);
+    game_func();
+}
+
+
+static void close_pipe(int *fds)
+{
+    if (fds[0] != -1) close(fds[0]);
+    if (fds[1] != -1) close(fds[1]);
+    fds[0] = fds[1] = -1;
+}
+
+
+static bool open_pipe(int *fds)
+{
+    if (pipe(fds) == -1) return false;
+    if ((fcntl(fds[0], F_SETFL, O_NONBLOCK) == -1) || (fcntl(fds[1], F_SETFL, O_NONBLOCK) == -1))
+    {
+        close_pipe(fds);
+        return false;
+    }
+
+    return true;
+}
+
+
+static void net_thread_cleanup(void)
+{
+    close_pipe(net_wake);
+    close_pipe(game_wake);
+    if (epoll_fd != -1) close(epoll_fd);
+    epoll_fd = -1;
+    mem_free(slots);
+    slots = NULL;
+}
+
+
+/*
+ * Start the network thread. "func" is called on the game thread whenever the
+ * network thread has something for it.
+ */
+bool net_thread_start(void (*func)(void))
+{
+    struct epoll_event ev;
+    sigset_t all, old;
+    int err;
+
+    slots = mem_zalloc(MAX_PLAYERS * sizeof(*slots));
+    game_func = func;
+    net_stop = 0;
+    net_armed = game_armed = 0;
+
+    epoll_fd = epoll_create(NET_MAX_EVENTS);
+    if ((epoll_fd == -1) || !open_pipe(net_wake) || !open_pipe(game_wake))
+    {
+        plog_fmt("Cannot set up the network thread, errno %d", errno);
+        net_thread_cleanup();
+        return false;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u64 = NET_WAKEUP;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, net_wake[0], &ev) == -1)
+    {
+        plog_fmt("Cannot set up the network thread, errno %d", errno);
+        net_thread_cleanup();
+        return false;
+    }
+
+    /* Signals are for the game thread */
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    err = pthread_create(&net_thread, NULL, net_thread_main, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err)
+    {
+        plog_fmt("Cannot start the network thread, error %d", err);
+        net_thread_cleanup();
+        return false;
+    }
+
+    install_input(net_thread_ready, game_wake[0], 0);
+    net_running = true;
+
+    return true;
+}
+
+
+void net_thread_stop(void)
+{
+    int i;
+
+    if (!net_running) return;
+
+    __atomic_store_n(&net_stop, 1, __ATOMIC_RELEASE);
+    pipe_poke(net_wake[1]);
+    pthread_join(net_thread, NULL);
+    remove_input(game_wake[0]);
+    net_running = false;
+
+    for (i = 0; i < MAX_PLAYERS; i++)
+    {
+        mem_free(slots[i].in.data);
+        mem_free(slots[i].out.data);
+    }
+    net_thread_cleanup();
+}
+
+
+bool net_thread_running(void)
+{
+    return net_running;
+}
+
+
+/*
+ * Hand the socket of a connection over to the network thread.
+ */
+bool net_thread_attach(int ind, int fd)
+{
+    struct net_slot *slot = &slots[ind];
+    bool ok;
+
+    pthread_mutex_lock(&net_lock);
+    slot->fd = fd;
+    slot->in.data = mem_alloc(NET_RING_SIZE);
+    slot->out.data = mem_alloc(NET_RING_SIZE);
+    slot->in.head = slot->in.tail = 0;
+    slot->out.head = slot->out.tail = 0;
+    slot->in_full = 0;
+    slot->status = NET_OK;
+    slot->drain_mark = 0;
+    slot->events = 0;
+    slot->active = ok = slot_watch(slot, EPOLLIN);
+    if (!ok)
+    {
+        mem_free(slot->in.data);
+        mem_free(slot->out.data);
+        slot->in.data = slot->out.data = NULL;
+    }
+    pthread_mutex_unlock(&net_lock);
+
+    return ok;
+}
+
+
+/*
+ * Take the socket of a connection back from the network thread, handing what
+ * is left in the outbound ring to the kernel on the way.
+ * Returns false if some of it had to be dropped.
+ */
+bool net_thread_detach(int ind)
+{
+    struct net_slot *slot;
+    struct iovec iov[2];
+    uint32_t used;
+    ssize_t n = 0;
+
+    if (!net_running || !slots[ind].active) return true;
+    slot = &slots[ind];
+
+    pthread_mutex_lock(&net_lock);
+    slot_watch(slot, 0);
+    slot->active = false;
+    slot->gen++;
+    pthread_mutex_unlock(&net_lock);
+
+    used = ring_used(&slot->out);
+    if (used && !slot->status)
+    {
+        while (((n = writev(slot->fd, iov, ring_segments(&slot->out, slot->out.head, used, iov))) < 0) &&
+            (errno == EINTR)) ;
+    }
+
+    mem_free(slot->in.data);
+    mem_free(slot->out.data);
+    slot->in.data = slot->out.data = NULL;
+
+    return (n == (ssize_t)used);
+}
+
+
+bool net_thread_attached(int ind)
+{
+    return (net_running && slots[ind].active);
+}
+
+
+/*
+ * Take up to "len" bytes of input from a connection.
+ */
+int net_thread_read(int ind, char *buf, int len)
+{
+    struct net_slot *slot = &slots[ind];
+    struct iovec iov[2];
+    uint32_t n = MIN((uint32_t)len, ring_used(&slot->in));
+    int i, count;
+
+    if (!n) return 0;
+
+    count = ring_segments(&slot->in, slot->in.head, n, iov);
+    for (i = 0; i < count; i++)
+    {
+        memcpy(buf, iov[i].iov_base, iov[i].iov_len);
+        buf += iov[i].iov_len;
+    }
+    ring_consumed(&slot->in, n);
+
+    /* The network thread stopped reading, tell it there is room again */
+    if (__atomic_exchange_n(&slot->in_full, 0, __ATOMIC_SEQ_CST)) wake_net();
+
+    return (int)n;
+}
+
+
+/*
+ * Queue up to "len" bytes of output for a connection.
+ * Returns the number of bytes that fit.
+ */
+int net_thread_write(int ind, char *buf, int len)
+{
+    struct net_slot *slot = &slots[ind];
+    struct iovec iov[2];
+    uint32_t n = MIN((uint32_t)len, NET_RING_SIZE - ring_used(&slot->out));
+    int i, count;
+
+    if (!n) return 0;
+
+    count = ring_segments(&slot->out, slot->out.tail, n, iov);
+    for (i = 0; i < count; i++)
+    {
+        memcpy(iov[i].iov_base, buf, iov[i].iov_len);
+        buf += iov[i].iov_len;
+    }
+    ring_produced(&slot->out, n);
+    wake_net();
+
+    return (int)n;
+}
+
+
+long net_thread_pending_in(int ind)
+{
+    return (long)ring_used(&slots[ind].in);
+}
+
+
+long net_thread_pending_out(int ind)
+{
+    return (long)ring_used(&slots[ind].out);
+}
+
+
+/*
+ * Check whether the kernel took some output since the last call.
+ */
+bool net_thread_drained(int ind)
+{
+    struct net_slot *slot = &slots[ind];
+    uint32_t head = __atomic_load_n(&slot->out.head, __ATOMIC_ACQUIRE);
+
+    if (head == slot->drain_mark) return false;
+    slot->drain_mark = head;
+
+    return true;
+}
+
+
+int net_thread_status(int ind)
+{
+    return __atomic_load_n(&slots[ind].status, __ATOMIC_ACQUIRE);
+}
+
+#endif /* USE_NET_THREAD */
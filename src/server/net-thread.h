@@ -0,0 +1,31 @@
+/*
+ * File: net-thread.h
+ * Purpose: Network I/O thread for player connections
+ */
+
+#ifndef INCLUDED_NET_THREAD_H
+#define INCLUDED_NET_THREAD_H
+
+#ifdef USE_NET_THREAD
+
+/* Connection status, as seen by the network thread */
+#define NET_OK      0
+#define NET_CLOSED  1   /* The client closed the connection, or a read failed */
+#define NET_BROKEN  2   /* A write failed */
+
+extern bool net_thread_start(void (*func)(void));
+extern void net_thread_stop(void);
+extern bool net_thread_running(void);
+extern bool net_thread_attach(int ind, int fd);
+extern bool net_thread_detach(int ind);
+extern bool net_thread_attached(int ind);
+extern int net_thread_read(int ind, char *buf, int len);
+extern int net_thread_write(int ind, char *buf, int len);
+extern long net_thread_pending_in(int ind);
+extern long net_thread_pending_out(int ind);
+extern bool net_thread_drained(int ind);
+extern int net_thread_status(int ind);
+
+#endif /* USE_NET_THREAD */
+
+#endif /* INCLUDED_NET_THREAD_H */
@@ -23,11 +23,29 @@
 #define MAX_RELIABLE_DATA_PACKET_SIZE   512
 #define MAX_TEXTFILE_CHUNK              512
 
+/* First client version that understands PKT_LINE_DELTA */
+#define LINE_DELTA_VERSION              35
+
+/* First client version that understands PKT_COMPRESSED */
+#define COMPRESS_VERSION                36
+
+/* Setup data smaller than this is sent as is */
+#define COMPRESS_MIN_SIZE               128
+
+/* First client version that can cache struct info */
+#define STRUCT_CACHE_VERSION            37
+
 
 static server_setup_t Setup;
+
+/* Digest of each struct info block (the same for every client) */
+static char struct_digest[STRUCT_INFO_MAX][MD5_HEX_SIZE];
 static int login_in_progress;
 static int num_logins, num_logouts;
 
+/* Traffic per packet type, for the whole server */
+static struct pkt_stats pkt_totals[PKT_MAX];
+
 
 /* The contact socket */
 static int Socket;
@@ -97,6 +115,11 @@ void set_player_index(connection_t *connp, long idx)
 /*** General utilities ***/
 
 
+#ifdef USE_NET_THREAD
+static void Net_thread_input(void);
+#endif
+
+
 /*
  * Initialize the connection structures.
  */
@@ -106,6 +129,12 @@ int Setup_net_server(void)
 
     init_connections();
 
+#ifdef USE_NET_THREAD
+    /* Move the socket I/O of the players off the game thread */
+    if (cfg_net_thread && net_thread_start(Net_thread_input))
+        plog("Network thread started");
+#endif
+
     init_players();
 
     /* Tell the metaserver that we're starting up */
@@ -141,6 +170,286 @@ void Conn_set_state(connection_t *connp, int state, long timeout)
 }
 
 
+/*** Outbound queue ***/
+
+
+/*
+ * Data that doesn't fit in the socket buffer is queued per connection and
+ * drained whenever the socket becomes writable again, so a burst of output
+ * (full map, store lists, knowledge menus) no longer kicks a player on a slow
+ * link. A connection whose backlog goes above the high watermark is flagged
+ * as congested until it drains back below the low watermark; it is only
+ * dropped if the kernel doesn't take anything from it for a while, or if
+ * the backlog grows completely out of hand.
+ */
+#define MAX_SPARE_CHUNKS    64
+#define OUTPUT_HARD_LIMIT   8   /* times the high watermark */
+
+
+/* Chunks kept around so bursts don't hit the allocator every time */
+static struct out_chunk *spare_chunks;
+static int num_spare_chunks;
+
+
+static struct out_chunk *out_chunk_new(void)
+{
+    struct out_chunk *chunk = spare_chunks;
+
+    if (chunk)
+    {
+        spare_chunks = chunk->next;
+        num_spare_chunks--;
+    }
+    else
+        chunk = mem_alloc(sizeof(*chunk));
+
+    chunk->next = NULL;
+    chunk->start = 0;
+    chunk->len = 0;
+
+    return chunk;
+}
+
+
+static void out_chunk_free(struct out_chunk *chunk)
+{
+    if (num_spare_chunks < MAX_SPARE_CHUNKS)
+    {
+        chunk->next = spare_chunks;
+        spare_chunks = chunk;
+        num_spare_chunks++;
+    }
+    else
+        mem_free(chunk);
+}
+
+
+static void free_spare_chunks(void)
+{
+    while (spare_chunks)
+    {
+        struct out_chunk *chunk = spare_chunks;
+
+        spare_chunks = chunk->next;
+        mem_free(chunk);
+    }
+    num_spare_chunks = 0;
+}
+
+
+static void out_queue_append(struct out_queue *out, char *buf, int len)
+{
+    while (len > 0)
+    {
+        struct out_chunk *chunk = out->tail;
+        int n;
+
+        if (!chunk || (chunk->len == OUT_CHUNK_SIZE))
+        {
+            chunk = out_chunk_new();
+            if (out->tail) out->tail->next = chunk;
+            else out->head = chunk;
+            out->tail = chunk;
+        }
+
+        n = MIN(len, OUT_CHUNK_SIZE - chunk->len);
+        memcpy(chunk->data + chunk->len, buf, n);
+        chunk->len += n;
+        out->bytes += n;
+        buf += n;
+        len -= n;
+    }
+}
+
+
+/*
+ * Drop the first "len" bytes of the queue once the kernel has them.
+ */
+static void out_queue_consume(struct out_queue *out, int len)
+{
+    out->bytes -= len;
+    while (len > 0)
+    {
+        struct out_chunk *chunk = out->head;
+        int n = MIN(len, chunk->len - chunk->start);
+
+        chunk->start += n;
+        len -= n;
+
+        if (chunk->start == chunk->len)
+        {
+            out->head = chunk->next;
+            if (!out->head) out->tail = NULL;
+            out_chunk_free(chunk);
+        }
+    }
+}
+
+
+static void out_queue_wipe(struct out_queue *out)
+{
+    while (out->head)
+    {
+        struct out_chunk *chunk = out->head;
+
+        out->head = chunk->next;
+        out_chunk_free(chunk);
+    }
+    out->tail = NULL;
+    out->bytes = 0;
+    out->congested = false;
+}
+
+
+static void Handle_output(int fd, int arg);
+
+
+/*
+ * Hand some buffers to the kernel in one go.
+ * Returns the number of bytes sent (0 if the kernel is full), or -1 on a
+ * socket error.
+ */
+static int Conn_send(int sock, char **bufs, int *sizes, int count)
+{
+    int len;
+
+    errno = 0;
+    while ((len = DgramWritev(sock, bufs, sizes, count)) < 0)
+    {
+        if (errno == EINTR)
+        {
+            errno = 0;
+            continue;
+        }
+        if ((errno == EWOULDBLOCK) || (errno == EAGAIN)) return 0;
+        plog("Can't write on socket");
+        return -1;
+    }
+
+    return len;
+}
+
+
+/*
+ * Send as much queued data as the kernel will take, straight from the queue,
+ * then wait for the socket to become writable if anything is left.
+ * Returns -1 on a socket error.
+ */
+static int Conn_flush_output(int ind)
+{
+    connection_t *connp = get_connection(ind);
+    struct out_queue *out = &connp->out;
+
+#ifdef USE_NET_THREAD
+    /* The network thread does the writing: give it what it has room for */
+    if (net_thread_attached(ind))
+    {
+        if (net_thread_drained(ind)) ht_copy(&out->last_drain, &turn);
+        while (out->head)
+        {
+            struct out_chunk *chunk = out->head;
+            int size = chunk->len - chunk->start;
+            int len = net_thread_write(ind, chunk->data + chunk->start, size);
+
+            out_queue_consume(out, len);
+            if (len < size) break;
+        }
+        return 0;
+    }
+#endif
+
+    while (out->head)
+    {
+        char *bufs[DGRAM_IOV_MAX];
+        int sizes[DGRAM_IOV_MAX];
+        struct out_chunk *chunk;
+        int count = 0, total = 0, len;
+
+        for (chunk = out->head; chunk && (count < DGRAM_IOV_MAX); chunk = chunk->next)
+        {
+            bufs[count] = chunk->data + chunk->start;
+            sizes[count] = chunk->len - chunk->start;
+            total += sizes[count++];
+        }
+
+        if ((len = Conn_send(connp->w.sock, bufs, sizes, count)) < 0) return -1;
+        if (len > 0) ht_copy(&out->last_drain, &turn);
+        out_queue_consume(out, len);
+
+        /* The kernel is full */
+        if (len < total) break;
+    }
+
+    if (out->head) install_output(Handle_output, connp->w.sock, ind);
+    else remove_output(connp->w.sock);
+
+    return 0;
+}
+
+
+/*
+ * Apply the watermarks to the outbound backlog of a connection.
+ * Returns false if the connection had to be dropped.
+ */
+static bool Conn_check_backlog(int ind)
+{
+    connection_t *connp = get_connection(ind);
+    struct out_queue *out = &connp->out;
+    long pending = out->bytes;
+    long high = cfg_output_high_water * 1024L;
+    long low = MIN(cfg_output_low_water, cfg_output_high_water) * 1024L;
+
+#ifdef USE_NET_THREAD
+    /* Count what the network thread still holds */
+    if (net_thread_attached(ind)) pending += net_thread_pending_out(ind);
+#endif
+
+    if (pending > high * OUTPUT_HARD_LIMIT)
+    {
+        plog_fmt("Output queue overflow (%ld bytes)", pending);
+        Destroy_connection(ind, "Output queue overflow");
+        return false;
+    }
+
+    if (!out->congested)
+    {
+        if (pending > high) out->congested = true;
+    }
+    else if (pending <= low)
+        out->congested = false;
+    else if (ht_diff(&turn, &out->last_drain) > (uint32_t)(cfg_output_stall_timeout * cfg_fps))
+    {
+        plog_fmt("Output stalled (%ld bytes)", pending);
+        Destroy_connection(ind, "Output stalled");
+        return false;
+    }
+
+    return true;
+}
+
+
+/*
+ * The socket of a connection with pending output became writable.
+ */
+static void Handle_output(int fd, int arg)
+{
+    int ind = arg;
+    connection_t *connp = get_connection(ind);
+
+    if (connp->w.sock != fd)
+    {
+        remove_output(fd);
+        return;
+    }
+
+    if (Conn_flush_output(ind) == -1)
+    {
+        plog("Cannot flush queued data");
+        Destroy_connection(ind, "Cannot flush queued data");
+    }
+}
+
+
 /*
  * Actually quit. This was separated to allow us to "quit" when a quit packet has not been received,
  * such as when our TCP connection is severed.
@@ -165,6 +474,11 @@ static void do_quit(int ind)
         dungeon_master = is_dm_p(p);
     }
 
+#ifdef USE_NET_THREAD
+    /* Take the socket back from the network thread */
+    net_thread_detach(ind);
+#endif
+
     /* Close the socket */
     SocketClose(connp->w.sock);
 
@@ -173,6 +487,7 @@ static void do_quit(int ind)
 
     /* Disable all output and input to and from this player */
     connp->w.sock = -1;
+    out_queue_wipe(&connp->out);
 
     /* Check for immediate disconnection */
     if (town_area(&wpos) || dungeon_master)
@@ -190,10 +505,217 @@ static void do_quit(int ind)
 }
 
 
+/*** Packet statistics ***/
+
+
+static const char *pkt_names[] =
+{
+    #define PKT(a, b, c, d, e) #a,
+    #include "../common/list-packets.h"
+    #undef PKT
+    NULL
+};
+
+
+/*
+ * Count the packets written to the command buffer since the last call.
+ * This is called before each packet is started (and before the buffer is
+ * sent), so the bytes since the mark belong to the packet whose type byte
+ * is found there.
+ */
+static void Conn_count_output(connection_t *connp)
+{
+    int len = connp->c.len - connp->pkt_mark;
+    int type;
+
+    if (len > 0)
+    {
+        type = (uint8_t)connp->c.buf[connp->pkt_mark];
+        if (type >= PKT_MAX) type = PKT_UNDEFINED;
+
+        pkt_totals[type].sent++;
+        pkt_totals[type].sent_bytes += len;
+        if (connp->pkt_stats)
+        {
+            connp->pkt_stats[type].sent++;
+            connp->pkt_stats[type].sent_bytes += len;
+        }
+    }
+
+    connp->pkt_mark = connp->c.len;
+}
+
+
+/*
+ * Describe the traffic of one packet type, for the whole server (ind = 0) or
+ * for one connection. Returns false if there was none.
+ */
+bool packet_stats_line(int ind, int type, char *buf, size_t len)
+{
+    struct pkt_stats *stats = pkt_totals;
+
+    if (ind)
+    {
+        connection_t *connp = get_connection(ind);
+
+        Conn_count_output(connp);
+        stats = connp->pkt_stats;
+        if (!stats) return false;
+    }
+
+    stats += type;
+    if (!stats->sent && !stats->recv && !stats->handler_time) return false;
+
+    strnfmt(buf, len, "%-20s %8lu %10.0f %10lu %10.0f %10.1f\n", pkt_names[type],
+        (unsigned long)stats->sent, (double)stats->sent_bytes, (unsigned long)stats->recv,
+        (double)stats->recv_bytes, (double)stats->handler_time / 1000000.0);
+
+    return true;
+}
+
+
+/*
+ * Write the traffic statistics to the file named in mangband.cfg, for the
+ * whole server and for each player still connected.
+ */
+void dump_packet_stats(void)
+{
+    char path[MSG_LEN], buf[NORMAL_WID];
+    ang_file *f;
+    int i, type;
+
+    if (!cfg_packet_stats_file || !cfg_packet_stats_file[0]) return;
+
+    path_build(path, sizeof(path), ANGBAND_DIR_USER, cfg_packet_stats_file);
+    f = file_open(path, MODE_WRITE, FTYPE_TEXT);
+    if (!f)
+    {
+        plog_fmt("Cannot write packet statistics to %s", path);
+        return;
+    }
+
+    file_putf(f, "Server totals\n\n" PACKET_STATS_HEADER);
+    for (type = 0; type < PKT_MAX; type++)
+    {
+        if (packet_stats_line(0, type, buf, sizeof(buf))) file_putf(f, "%s", buf);
+    }
+
+    for (i = 1; i <= NumPlayers; i++)
+    {
+        struct player *p = player_get(i);
+
+        file_putf(f, "\n%s (%s)\n\n" PACKET_STATS_HEADER, p->name, p->addr);
+        for (type = 0; type < PKT_MAX; type++)
+        {
+            if (packet_stats_line(p->conn, type, buf, sizeof(buf))) file_putf(f, "%s", buf);
+        }
+    }
+
+    file_close(f);
+}
+
+
+/*
+ * Get the slot of a supersedable packet, discarding its previous value.
+ */
+static sockbuf_t *get_slot(connection_t *connp, int slot)
+{
+    Sockbuf_clear(&connp->slots[slot]);
+    return &connp->slots[slot];
+}
+
+
+/*
+ * Append the latest value of each supersedable packet to the batch.
+ */
+static int Conn_flush_slots(connection_t *connp)
+{
+    int i;
+
+    for (i = 0; i < SLOT_MAX; i++)
+    {
+        sockbuf_t *slot = &connp->slots[i];
+
+        if (!slot->len) continue;
+        Conn_count_output(connp);
+        if (Sockbuf_write(&connp->c, slot->buf, slot->len) != slot->len) return -1;
+        Sockbuf_clear(slot);
+    }
+
+    return 0;
+}
+
+
+/*
+ * Forget what the client has on row "y" of its main map (all rows if -1).
+ */
+static void shadow_invalidate(connection_t *connp, int y)
+{
+    if (!connp->shadow.valid) return;
+
+    if (y == -1)
+        memset(connp->shadow.valid, 0, (z_info->dungeon_hgt + ROW_MAP + 1) * sizeof(bool));
+    else
+        connp->shadow.valid[y] = false;
+}
+
+
+static void shadow_free(connection_t *connp)
+{
+    mem_free(connp->shadow.scr);
+    mem_free(connp->shadow.trn);
+    mem_free(connp->shadow.valid);
+    memset(&connp->shadow, 0, sizeof(connp->shadow));
+}
+
+
+/*
+ * Check if lines of the main map can be sent as deltas to this client.
+ */
+static bool shadow_usable(connection_t *connp, struct player *p, int screen_wid)
+{
+    struct map_shadow *shadow = &connp->shadow;
+
+    if (connp->version < LINE_DELTA_VERSION) return false;
+
+    /* The lines go to another terminal */
+    if (p->remote_term != NTERM_WIN_OVERHEAD) return false;
+
+    if (!shadow->valid)
+    {
+        int rows = z_info->dungeon_hgt + ROW_MAP + 1;
+        int cols = z_info->dungeon_wid + COL_MAP;
+
+        shadow->scr = mem_zalloc(rows * cols * sizeof(cave_view_type));
+        shadow->trn = mem_zalloc(rows * cols * sizeof(cave_view_type));
+        shadow->valid = mem_zalloc(rows * sizeof(bool));
+    }
+
+    /* A different layout means the client redraws everything */
+    if ((shadow->screen_wid != screen_wid) || (shadow->tile_wid != p->tile_wid) ||
+        (shadow->tile_hgt != p->tile_hgt) || (shadow->graphics != (bool)p->use_graphics))
+    {
+        shadow_invalidate(connp, -1);
+        shadow->screen_wid = screen_wid;
+        shadow->tile_wid = p->tile_wid;
+        shadow->tile_hgt = p->tile_hgt;
+        shadow->graphics = (bool)p->use_graphics;
+    }
+
+    return true;
+}
+
+
+static cave_view_type *shadow_row(cave_view_type *rows, int y)
+{
+    return rows + y * (z_info->dungeon_wid + COL_MAP);
+}
+
+
 static int Send_reliable(int ind)
 {
     connection_t *connp = get_connection(ind);
-    int num_written;
+    int num_written = 0, len = connp->c.len;
 
     /*
      * Make sure we have a valid socket to write to.
@@ -201,21 +723,69 @@ static int Send_reliable(int ind)
      */
     if (connp->w.sock == -1) return 0;
 
-    if ((num_written = Sockbuf_write(&connp->w, connp->c.buf, connp->c.len)) != connp->c.len)
+    Conn_count_output(connp);
+
+    /*
+     * Keep the stream in order: once something is queued, everything goes
+     * behind it. Otherwise the kernel gets the data straight from the command
+     * buffer, and only what it doesn't take gets queued. With the network
+     * thread, its buffer stands in for the kernel.
+     */
+#ifdef USE_NET_THREAD
+    if (net_thread_attached(ind))
+    {
+        if (!connp->out.head && (len > 0))
+            num_written = net_thread_write(ind, connp->c.buf, len);
+    }
+    else
+#endif
+    if (!connp->out.head && (len > 0))
+        num_written = Conn_send(connp->w.sock, &connp->c.buf, &len, 1);
+    if (num_written < 0)
     {
-        plog_fmt("Cannot write reliable data (%d, %d)", num_written, connp->c.len);
+        plog_fmt("Cannot write reliable data (%d, %d)", num_written, len);
         Destroy_connection(ind, "Cannot write reliable data");
         return -1;
     }
-    if ((num_written = Sockbuf_flush(&connp->w)) < 0)
+    if (num_written > 0) ht_copy(&connp->out.last_drain, &turn);
+    if (num_written < len)
     {
-        plog_fmt("Cannot flush reliable data (%d)", num_written);
-        Destroy_connection(ind, "Cannot flush reliable data");
-        return -1;
+        out_queue_append(&connp->out, connp->c.buf + num_written, len - num_written);
+#ifdef USE_NET_THREAD
+        if (!net_thread_attached(ind))
+#endif
+        install_output(Handle_output, connp->w.sock, ind);
     }
     Sockbuf_clear(&connp->c);
-    return num_written;
+    connp->pkt_mark = 0;
+
+    if (!Conn_check_backlog(ind)) return -1;
+
+    return len;
+}
+
+
+#ifdef USE_NET_THREAD
+/*
+ * Move the input that the network thread received right behind the pending
+ * commands. Behaves like Sockbuf_read().
+ */
+static int Conn_read_net_thread(int ind)
+{
+    connection_t *connp = get_connection(ind);
+    sockbuf_t *q = &connp->q;
+    int n;
+
+    if (q->ptr > q->buf) Sockbuf_advance(q, q->ptr - q->buf);
+    n = net_thread_read(ind, q->buf + q->len, q->size - q->len);
+    q->len += n;
+
+    /* Nothing yet, or the client closed the connection */
+    errno = (((n > 0) || (net_thread_status(ind) != NET_OK))? 0: EAGAIN);
+
+    return n;
 }
+#endif
 
 
 /*
@@ -229,7 +799,7 @@ static int Send_reliable(int ind)
  */
 static void Handle_input(int fd, int arg)
 {
-    int ind = arg, old_numplayers = NumPlayers;
+    int ind = arg, old_numplayers = NumPlayers, n;
     connection_t *connp = get_connection(ind);
     struct player *p;
 
@@ -239,11 +809,22 @@ static void Handle_input(int fd, int arg)
     /* Handle "leaving" */
     if ((connp->id != -1) && player_get(get_player_index(connp))->upkeep->new_level_method) return;
 
-    /* Reset the buffer we are reading into */
-    Sockbuf_clear(&connp->r);
+    /*
+     * Read the new data right behind the pending commands: the command queue
+     * lends its buffer to the socket buffer for this
+     */
+#ifdef USE_NET_THREAD
+    if (net_thread_attached(ind))
+        n = Conn_read_net_thread(ind);
+    else
+#endif
+    {
+        Sockbuf_swap(&connp->r, &connp->q);
+        n = Sockbuf_read(&connp->r);
+        Sockbuf_swap(&connp->r, &connp->q);
+    }
 
-    /* Read in the data */
-    if (Sockbuf_read(&connp->r) <= 0)
+    if (n <= 0)
     {
         /*
          * On windows, we frequently get EWOULDBLOCK return codes, i.e.
@@ -259,14 +840,6 @@ static void Handle_input(int fd, int arg)
         return;
     }
 
-    /* Add this new data to the command queue */
-    if (Sockbuf_write(&connp->q, connp->r.ptr, connp->r.len) != connp->r.len)
-    {
-        errno = 0;
-        Destroy_connection(ind, "Can't copy queued data to buffer");
-        return;
-    }
-
     /* Execute any new commands immediately if possible */
     process_pending_commands(ind);
 
@@ -291,8 +864,14 @@ static void Handle_input(int fd, int arg)
      * PKT_END makes client pause with the net input and move to keyboard
      * so it's important to apply it at the end
      */
+    if (Conn_flush_slots(connp) == -1)
+    {
+        Destroy_connection(ind, "Net input write error");
+        return;
+    }
     if (connp->c.len > 0)
     {
+        Conn_count_output(connp);
         if (Packet_printf(&connp->c, "%b", (unsigned)PKT_END) <= 0)
         {
             Destroy_connection(ind, "Net input write error");
@@ -303,6 +882,32 @@ static void Handle_input(int fd, int arg)
 }
 
 
+#ifdef USE_NET_THREAD
+/*
+ * The network thread has input or bad news for some connections.
+ */
+static void Net_thread_input(void)
+{
+    int i;
+
+    for (i = 0; i < MAX_PLAYERS; i++)
+    {
+        connection_t *connp = get_connection(i);
+
+        if ((connp->w.sock == -1) || !net_thread_attached(i)) continue;
+
+        if (net_thread_status(i) == NET_BROKEN)
+        {
+            plog("Cannot write reliable data");
+            Destroy_connection(i, "Cannot write reliable data");
+        }
+        else if (net_thread_pending_in(i) || net_thread_status(i))
+            Handle_input(connp->w.sock, i);
+    }
+}
+#endif
+
+
 static uint16_t get_flavor_max(void)
 {
     struct flavor *f;
@@ -375,6 +980,12 @@ static int Setup_connection(uint32_t account, char *real, char *nick, char *addr
     Sockbuf_init(&connp->r, sock, SERVER_RECV_SIZE, SOCKBUF_WRITE | SOCKBUF_READ);
     Sockbuf_init(&connp->c, -1, SERVER_SEND_SIZE, SOCKBUF_WRITE | SOCKBUF_READ | SOCKBUF_LOCK);
     Sockbuf_init(&connp->q, -1, SERVER_RECV_SIZE, SOCKBUF_WRITE | SOCKBUF_READ | SOCKBUF_LOCK);
+    for (i = 0; i < SLOT_MAX; i++)
+    {
+        Sockbuf_init(&connp->slots[i], -1, SLOT_SIZE, SOCKBUF_WRITE | SOCKBUF_READ | SOCKBUF_LOCK);
+        if (connp->slots[i].buf == NULL) memory_error = true;
+    }
+    ht_copy(&connp->out.last_drain, &turn);
 
     connp->id = -1;
     connp->conntype = conntype;
@@ -397,6 +1008,7 @@ static int Setup_connection(uint32_t account, char *real, char *nick, char *addr
         connp->version = version;
         ht_copy(&connp->start, &turn);
         connp->timeout = SETUP_TIMEOUT;
+        connp->pkt_stats = mem_zalloc(PKT_MAX * sizeof(struct pkt_stats));
 
         if (!connp->has_setup)
         {
@@ -450,7 +1062,10 @@ static int Setup_connection(uint32_t account, char *real, char *nick, char *addr
     /* Remove the contact input handler */
     remove_input(sock);
     
-    /* Install the game input handler */
+    /* Hand the socket to the network thread, or install the game input handler */
+#ifdef USE_NET_THREAD
+    if (!net_thread_running() || !net_thread_attach(free_conn_index, sock))
+#endif
     install_input(Handle_input, sock, free_conn_index);
 
     return free_conn_index;
@@ -897,6 +1512,9 @@ static void Delete_player(int id)
     /* Leave chat channels */
     channels_leave(p);
 
+    /* Player is no longer on the level */
+    chunk_roster_remove(p);
+
     /* Unstatic if the DM left while manually designing a dungeon level */
     if (chunk_inhibit_players(&p->wpos)) chunk_set_player_count(&p->wpos, 0);
 
@@ -1050,6 +1668,8 @@ static void wipe_connection(connection_t *connp)
 void Destroy_connection(int ind, char *reason)
 {
     connection_t *connp = get_connection(ind);
+    int i;
+    bool flushed = true;
 
     if (connp->state == CONN_FREE)
     {
@@ -1058,9 +1678,15 @@ void Destroy_connection(int ind, char *reason)
         return;
     }
 
+#ifdef USE_NET_THREAD
+    /* Take the socket back from the network thread */
+    flushed = net_thread_detach(ind);
+#endif
+
     if (connp->conntype == CONNTYPE_PLAYER)
     {
-        if (connp->w.sock != -1)
+        /* Don't cut into the middle of a packet that is still on its way */
+        if ((connp->w.sock != -1) && !connp->out.head && flushed)
         {
             char pkt[NORMAL_WID];
             int len;
@@ -1094,6 +1720,11 @@ void Destroy_connection(int ind, char *reason)
     Sockbuf_cleanup(&connp->r);
     Sockbuf_cleanup(&connp->c);
     Sockbuf_cleanup(&connp->q);
+    for (i = 0; i < SLOT_MAX; i++) Sockbuf_cleanup(&connp->slots[i]);
+    shadow_free(connp);
+    out_queue_wipe(&connp->out);
+    mem_free(connp->struct_cache);
+    mem_free(connp->pkt_stats);
 
     if (connp->w.sock != -1)
     {
@@ -1140,6 +1771,11 @@ void Stop_net_server(void)
     /* Remove listening socket */
     if (Socket != -2) remove_input(Socket);
     Sockbuf_cleanup(&ibuf);
+    free_spare_chunks();
+
+#ifdef USE_NET_THREAD
+    net_thread_stop();
+#endif
 
     /* Destroy networking */
 #ifdef WINDOWS
@@ -1359,13 +1995,75 @@ uint8_t *Conn_get_console_channels(int ind)
 }
 
 
+/*
+ * Input received but not processed yet, and output not sent yet, in bytes.
+ */
+void Conn_get_queued(int ind, long *in, long *out)
+{
+    connection_t *connp = get_connection(ind);
+
+    *in = connp->q.len - (connp->q.ptr - connp->q.buf);
+    *out = connp->out.bytes;
+
+#ifdef USE_NET_THREAD
+    if (net_thread_attached(ind))
+    {
+        *in += net_thread_pending_in(ind);
+        *out += net_thread_pending_out(ind);
+    }
+#endif
+}
+
+
 /*** Sending ***/
 
 
+/*
+ * Replace the setup packets written to the connection buffer since "start"
+ * by a single PKT_COMPRESSED packet, if the client supports it and it helps.
+ */
+static void Conn_compress_setup(connection_t *connp, int start)
+{
+    int len = connp->c.len - start, n;
+    char *data, *ptr;
+
+    /* The connection may have been destroyed meanwhile */
+    if (connp->state != CONN_SETUP) return;
+
+    Conn_count_output(connp);
+    connp->setup_bytes += len;
+    connp->setup_sent += len;
+
+    if (!cfg_compress_setup || (connp->version < COMPRESS_VERSION) || (len < COMPRESS_MIN_SIZE))
+        return;
+
+    data = mem_alloc(LZ_BOUND(len));
+    n = lz_compress(connp->c.buf + start, len, data, LZ_BOUND(len));
+
+    /* Keep the original if it's smaller (the header takes 9 bytes) */
+    if ((n > 0) && (n + 9 < len))
+    {
+        connp->c.len = start;
+        ptr = Packet_reserve(&connp->c, n + 9);
+        ptr = Packet_put_byte(ptr, PKT_COMPRESSED);
+        ptr = Packet_put_u32(ptr, len);
+        ptr = Packet_put_u32(ptr, n);
+        memcpy(ptr, data, n);
+        Packet_commit(&connp->c, ptr + n);
+        connp->pkt_mark = connp->c.len;
+        connp->setup_sent -= len - (n + 9);
+    }
+
+    mem_free(data);
+}
+
+
 int Send_basic_info(int ind)
 {
     connection_t *connp = get_connection(ind);
 
+    Conn_count_output(connp);
+
     if (connp->state != CONN_SETUP)
     {
         errno = 0;
@@ -2218,6 +2916,9 @@ static connection_t *get_connp(struct player *p, const char *errmsg)
         return NULL;
     }
 
+    /* A new packet starts */
+    Conn_count_output(connp);
+
     return connp;
 }
 
@@ -2303,12 +3004,27 @@ int Send_gold(struct player *p, int32_t au)
 }
 
 
+/*
+ * Packets made of a type and two 16-bit values (hp, sp)
+ */
+static int write_pair(sockbuf_t *buf, uint8_t type, int16_t max, int16_t cur)
+{
+    char *ptr = Packet_reserve(buf, 5);
+
+    if (!ptr) return -1;
+    ptr = Packet_put_byte(ptr, type);
+    ptr = Packet_put_s16(ptr, max);
+    ptr = Packet_put_s16(ptr, cur);
+    return Packet_commit(buf, ptr);
+}
+
+
 int Send_hp(struct player *p, int mhp, int chp)
 {
     connection_t *connp = get_connp(p, "hp");
     if (connp == NULL) return 0;
 
-    return Packet_printf(&connp->c, "%b%hd%hd", (unsigned)PKT_HP, mhp, chp);
+    return write_pair(get_slot(connp, SLOT_HP), PKT_HP, mhp, chp);
 }
 
 
@@ -2317,7 +3033,7 @@ int Send_sp(struct player *p, int msp, int csp)
     connection_t *connp = get_connp(p, "sp");
     if (connp == NULL) return 0;
 
-    return Packet_printf(&connp->c, "%b%hd%hd", (unsigned)PKT_SP, msp, csp);
+    return write_pair(get_slot(connp, SLOT_SP), PKT_SP, msp, csp);
 }
 
 
@@ -2429,16 +3145,21 @@ int Send_depth(struct player *p)
 int Send_status(struct player *p, int16_t *effects)
 {
     int i;
+    sockbuf_t *slot;
+    char *ptr;
 
     connection_t *connp = get_connp(p, "blind");
     if (connp == NULL) return 0;
 
-    Packet_printf(&connp->c, "%b", (unsigned)PKT_STATUS);
+    slot = get_slot(connp, SLOT_STATUS);
+    ptr = Packet_reserve(slot, 1 + TMD_MAX * 2);
+    if (!ptr) return -1;
 
+    ptr = Packet_put_byte(ptr, PKT_STATUS);
     for (i = 0; i < TMD_MAX; i++)
-        Packet_printf(&connp->c, "%hd", (int)effects[i]);
+        ptr = Packet_put_s16(ptr, effects[i]);
 
-    return 1;
+    return Packet_commit(slot, ptr);
 }
 
 
@@ -2454,12 +3175,28 @@ int Send_recall(struct player *p, int16_t word_recall, int16_t deep_descent)
 
 int Send_state(struct player *p, bool stealthy, bool resting, bool unignoring, bool afraid, const char *terrain)
 {
+    sockbuf_t *slot;
+    char *ptr;
+
     connection_t *connp = get_connp(p, "state");
     if (connp == NULL) return 0;
 
-    return Packet_printf(&connp->c, "%b%hd%hd%hd%hd%hd%hd%hd%hd%s", (unsigned)PKT_STATE, (int)stealthy,
-        (int)resting, (int)unignoring, (int)p->obj_feeling, (int)p->mon_feeling,
-        (int)p->square_light, p->state.num_moves, (int)afraid, terrain);
+    slot = get_slot(connp, SLOT_STATE);
+    ptr = Packet_reserve(slot, 17 + Packet_str_size(terrain, NORMAL_WID));
+    if (!ptr) return -1;
+
+    ptr = Packet_put_byte(ptr, PKT_STATE);
+    ptr = Packet_put_s16(ptr, stealthy);
+    ptr = Packet_put_s16(ptr, resting);
+    ptr = Packet_put_s16(ptr, unignoring);
+    ptr = Packet_put_s16(ptr, p->obj_feeling);
+    ptr = Packet_put_s16(ptr, p->mon_feeling);
+    ptr = Packet_put_s16(ptr, p->square_light);
+    ptr = Packet_put_s16(ptr, p->state.num_moves);
+    ptr = Packet_put_s16(ptr, afraid);
+    ptr = Packet_put_str(ptr, terrain, NORMAL_WID);
+
+    return Packet_commit(slot, ptr);
 }
 
 
@@ -2473,16 +3210,16 @@ int Send_state(struct player *p, bool stealthy, bool resting, bool unignoring, b
  * "lineref" is a pointer to an attr/char array, and "max_col" is specifying its size
  *
  * Note! To sucessfully decode, client MUST use the same "mode"
+ *
+ * The caller must have reserved RLE_MAX_SIZE(max_col) bytes at "ptr".
+ * Returns the position after the last byte written.
  */
-static int rle_encode(sockbuf_t* buf, cave_view_type* lineref, int max_col, int mode)
+static char *rle_write(char *ptr, cave_view_type* lineref, int max_col, int mode)
 {
     int x1, i;
     char c;
     uint16_t a, n;
 
-    /* Count bytes */
-    int b = 0;
-
     /* Each column */
     for (i = 0; i < max_col; i++)
     {
@@ -2497,58 +3234,48 @@ static int rle_encode(sockbuf_t* buf, cave_view_type* lineref, int max_col, int
         n = 1;
 
         /* Count repetitions of this grid */
-        while (mode && (lineref[x1].c == c) && (lineref[x1].a == a) && (x1 < max_col))
+        while (mode && (x1 < max_col) && (lineref[x1].c == c) && (lineref[x1].a == a))
         {
             /* Increment count and column */
             n++;
             x1++;
         }
 
-        /* RLE_LARGE if there are at least 2 similar grids in a row */
-        if ((mode == RLE_LARGE) && (n >= 2))
+        /* Normal, single grid */
+        if (!mode || (n < 2))
         {
-            /* Set bit 0x8000 of a */
-            a |= 0x8000;
-
-            /* Output the info */
-            Packet_printf(buf, "%c%hu%hu", (int)c, (unsigned)a, (unsigned)n);
-
-            /* Start again after the run */
-            i = x1 - 1;
-
-            /* Count bytes */
-            b += 5;
+            ptr = Packet_put_char(ptr, c);
+            ptr = Packet_put_u16(ptr, a);
+            continue;
         }
 
-        /* RLE_CLASSIC if there are at least 2 similar grids in a row */
-        else if ((mode == RLE_CLASSIC) && (n >= 2))
-        {
-            /* Set bit 0x40 of a */
-            a |= 0x40;
+        /* RLE_LARGE: set bit 0x8000 of a, RLE_CLASSIC: set bit 0x40 of a */
+        a |= ((mode == RLE_LARGE)? 0x8000: 0x40);
 
-            /* Output the info */
-            Packet_printf(buf, "%c%hu%hu", (int)c, (unsigned)a, (unsigned)n);
+        /* Output the info */
+        ptr = Packet_put_char(ptr, c);
+        ptr = Packet_put_u16(ptr, a);
+        ptr = Packet_put_u16(ptr, n);
 
-            /* Start again after the run */
-            i = x1 - 1;
+        /* Start again after the run */
+        i = x1 - 1;
+    }
 
-            /* Count bytes */
-            b += 5;
-        }
+    return ptr;
+}
 
-        /* Normal, single grid */
-        else
-        {
-            /* Output the info */
-            Packet_printf(buf, "%c%hu", (int)c, (unsigned)a);
 
-            /* Count bytes */
-            b += 3;
-        }
-    }
+/*
+ * Encodes an attr/char pairs stream into a socket buffer.
+ *
+ * Returns the number of bytes written, or -1 if the buffer is full.
+ */
+static int rle_encode(sockbuf_t* buf, cave_view_type* lineref, int max_col, int mode)
+{
+    char *ptr = Packet_reserve(buf, RLE_MAX_SIZE(max_col));
 
-    /* Report total bytes */
-    return b;
+    if (!ptr) return -1;
+    return Packet_commit(buf, rle_write(ptr, lineref, max_col, mode));
 }
 
 
@@ -2614,11 +3341,97 @@ static connection_t* get_mind_link(struct player *p)
  * the next byte contains the number of repetitions of the previous grid.
  */
 #define DUNGEON_RLE_MODE(P) ((P)->use_graphics? RLE_LARGE: RLE_CLASSIC)
+
+
+/*
+ * Changes closer than this are sent as one span (a span header costs about
+ * as much as two grids)
+ */
+#define DELTA_SPAN_GAP  2
+
+/* Past this many spans, the whole line is sent instead */
+#define DELTA_MAX_SPANS 32
+
+
+/*
+ * Send only the parts of a line of the main map that differ from what the
+ * client already has.
+ *
+ * Returns false if the whole line is cheaper to send.
+ */
+static bool Send_line_delta(connection_t *connp, struct player *p, int y, int screen_wid)
+{
+    cave_view_type *scr = p->scr_info[y], *trn = p->trn_info[y];
+    cave_view_type *old_scr = shadow_row(connp->shadow.scr, y);
+    cave_view_type *old_trn = shadow_row(connp->shadow.trn, y);
+    int16_t from[DELTA_MAX_SPANS], to[DELTA_MAX_SPANS];
+    int x, n = 0, changed = 0;
+    char *ptr;
+
+    /* Collect the spans of changed grids */
+    for (x = 0; x < screen_wid; x++)
+    {
+        if ((scr[x].a == old_scr[x].a) && (scr[x].c == old_scr[x].c) && (!p->use_graphics ||
+            ((trn[x].a == old_trn[x].a) && (trn[x].c == old_trn[x].c))))
+        {
+            continue;
+        }
+
+        /* Extend the current span over a short gap */
+        if (n && (x - to[n - 1] <= DELTA_SPAN_GAP))
+        {
+            changed += x + 1 - to[n - 1];
+            to[n - 1] = x + 1;
+            continue;
+        }
+
+        /* Too fragmented */
+        if (n == DELTA_MAX_SPANS) return false;
+
+        from[n] = x;
+        to[n] = x + 1;
+        changed++;
+        n++;
+    }
+
+    /* Nothing changed */
+    if (!n) return true;
+
+    /* Most of the line changed */
+    if (changed * 4 > screen_wid * 3) return false;
+
+    /* Room for the header, the span headers and the changed grids */
+    ptr = Packet_reserve(&connp->c, 7 + n * 4 + RLE_MAX_SIZE(changed) * (p->use_graphics? 2: 1));
+    if (!ptr) return false;
+
+    ptr = Packet_put_byte(ptr, PKT_LINE_DELTA);
+    ptr = Packet_put_s16(ptr, y);
+    ptr = Packet_put_s16(ptr, screen_wid);
+    ptr = Packet_put_s16(ptr, n);
+    for (x = 0; x < n; x++)
+    {
+        int len = to[x] - from[x];
+
+        ptr = Packet_put_s16(ptr, from[x]);
+        ptr = Packet_put_s16(ptr, len);
+        if (p->use_graphics) ptr = rle_write(ptr, trn + from[x], len, RLE_LARGE);
+        ptr = rle_write(ptr, scr + from[x], len, DUNGEON_RLE_MODE(p));
+        memcpy(old_scr + from[x], scr + from[x], len * sizeof(cave_view_type));
+        memcpy(old_trn + from[x], trn + from[x], len * sizeof(cave_view_type));
+    }
+    Packet_commit(&connp->c, ptr);
+
+    return true;
+}
+
+
 int Send_line_info(struct player *p, int y)
 {
     struct player *p_ptr2 = NULL;
     connection_t *connp, *connp2;
     int screen_wid, screen_wid2 = 0;
+    bool delta;
+    char *ptr;
 
     connp = get_connp(p, "line info");
     if (connp == NULL) return 0;
@@ -2630,26 +3443,63 @@ int Send_line_info(struct player *p, int y)
     {
         p_ptr2 = find_player(p->esp_link);
         screen_wid2 = p_ptr2->screen_cols / p_ptr2->tile_wid;
+        Conn_count_output(connp2);
     }
 
-    /* Put a header on the packet */
-    Packet_printf(&connp->c, "%b%hd%hd", (unsigned)PKT_LINE_INFO, y, screen_wid);
+    /* Reset the line counter */
+    if (y == -1)
+    {
+        Packet_printf(&connp->c, "%b%hd%hd", (unsigned)PKT_LINE_INFO, y, screen_wid);
+        if (connp2)
+            Packet_printf(&connp2->c, "%b%hd%hd", (unsigned)PKT_LINE_INFO, y, screen_wid2);
+        return 1;
+    }
+
+    /* The mind-linked client always gets the whole line, which replaces its own */
     if (connp2)
+    {
         Packet_printf(&connp2->c, "%b%hd%hd", (unsigned)PKT_LINE_INFO, y, screen_wid2);
+        if (p_ptr2->use_graphics)
+            rle_encode(&connp2->c, p->trn_info[y], screen_wid2, RLE_LARGE);
+        rle_encode(&connp2->c, p->scr_info[y], screen_wid2, DUNGEON_RLE_MODE(p_ptr2));
+        shadow_invalidate(connp2, y);
+    }
 
-    /* Reset the line counter */
-    if (y == -1) return 1;
+    /* Only send what changed if the client already has this line */
+    delta = shadow_usable(connp, p, screen_wid);
+    if (delta && connp->shadow.valid[y] && Send_line_delta(connp, p, y, screen_wid))
+        return 1;
+
+    /* Room for the header and both attr/char streams */
+    ptr = Packet_reserve(&connp->c, 5 + RLE_MAX_SIZE(screen_wid) * (p->use_graphics? 2: 1));
+    if (!ptr)
+    {
+        shadow_invalidate(connp, y);
+        return -1;
+    }
+
+    /* Put a header on the packet */
+    ptr = Packet_put_byte(ptr, PKT_LINE_INFO);
+    ptr = Packet_put_s16(ptr, y);
+    ptr = Packet_put_s16(ptr, screen_wid);
 
     /* Encode and send the transparency attr/char stream */
     if (p->use_graphics)
-        rle_encode(&connp->c, p->trn_info[y], screen_wid, RLE_LARGE);
-    if (connp2 && p_ptr2->use_graphics)
-        rle_encode(&connp2->c, p->trn_info[y], screen_wid2, RLE_LARGE);
+        ptr = rle_write(ptr, p->trn_info[y], screen_wid, RLE_LARGE);
 
     /* Encode and send the attr/char stream */
-    rle_encode(&connp->c, p->scr_info[y], screen_wid, DUNGEON_RLE_MODE(p));
-    if (connp2)
-        rle_encode(&connp2->c, p->scr_info[y], screen_wid2, DUNGEON_RLE_MODE(p_ptr2));
+    ptr = rle_write(ptr, p->scr_info[y], screen_wid, DUNGEON_RLE_MODE(p));
+    Packet_commit(&connp->c, ptr);
+
+    /* Remember what the client has now */
+    if (delta)
+    {
+        memcpy(shadow_row(connp->shadow.scr, y), p->scr_info[y],
+            screen_wid * sizeof(cave_view_type));
+        memcpy(shadow_row(connp->shadow.trn, y), p->trn_info[y],
+            screen_wid * sizeof(cave_view_type));
+        connp->shadow.valid[y] = true;
+    }
 
     return 1;
 }
@@ -2666,6 +3516,9 @@ int Send_remote_line(struct player *p, int y)
     /* Packet body */
     rle_encode(&connp->c, p->info[y], NORMAL_WID, DUNGEON_RLE_MODE(p));
 
+    /* This may land on the main map */
+    if (y >= 0) shadow_invalidate(connp, y);
+
     return 1;
 }
 
@@ -2707,6 +3560,29 @@ int Send_show_floor(struct player *p, uint8_t mode)
 }
 
 
+/*
+ * A single grid, with its transparency attr/char if "trn" is set
+ */
+static int write_char(sockbuf_t *buf, struct loc *grid, uint16_t a, char c, uint16_t ta, char tc,
+    bool trn)
+{
+    char *ptr = Packet_reserve(buf, (trn? 9: 6));
+
+    if (!ptr) return -1;
+    ptr = Packet_put_byte(ptr, PKT_CHAR);
+    ptr = Packet_put_byte(ptr, grid->x);
+    ptr = Packet_put_byte(ptr, grid->y);
+    ptr = Packet_put_u16(ptr, a);
+    ptr = Packet_put_char(ptr, c);
+    if (trn)
+    {
+        ptr = Packet_put_u16(ptr, ta);
+        ptr = Packet_put_char(ptr, tc);
+    }
+    return Packet_commit(buf, ptr);
+}
+
+
 int Send_char(struct player *p, struct loc *grid, uint16_t a, char c, uint16_t ta, char tc)
 {
     connection_t *connp, *connp2;
@@ -2733,25 +3609,30 @@ int Send_char(struct player *p, struct loc *grid, uint16_t a, char c, uint16_t t
     {
         struct player *p_ptr2 = find_player(p->esp_link);
 
-        if (p_ptr2->use_graphics && (p_ptr2->remote_term == NTERM_WIN_OVERHEAD))
-        {
-            Packet_printf(&connp2->c, "%b%b%b%hu%c%hu%c", (unsigned)PKT_CHAR, (unsigned)grid->x,
-                (unsigned)grid->y, (unsigned)a, (int)c, (unsigned)ta, (int)tc);
-        }
-        else
-        {
-            Packet_printf(&connp2->c, "%b%b%b%hu%c", (unsigned)PKT_CHAR, (unsigned)grid->x,
-                (unsigned)grid->y, (unsigned)a, (int)c);
-        }
+        Conn_count_output(connp2);
+        write_char(&connp2->c, grid, a, c, ta, tc,
+            p_ptr2->use_graphics && (p_ptr2->remote_term == NTERM_WIN_OVERHEAD));
+        shadow_invalidate(connp2, grid->y);
     }
 
-    if (p->use_graphics && (p->remote_term == NTERM_WIN_OVERHEAD))
+    /* Keep track of what the client has */
+    if ((p->remote_term == NTERM_WIN_OVERHEAD) && connp->shadow.valid && connp->shadow.valid[grid->y])
     {
-        return Packet_printf(&connp->c, "%b%b%b%hu%c%hu%c", (unsigned)PKT_CHAR, (unsigned)grid->x,
-            (unsigned)grid->y, (unsigned)a, (int)c, (unsigned)ta, (int)tc);
+        cave_view_type *scr = shadow_row(connp->shadow.scr, grid->y) + grid->x;
+        cave_view_type *trn = shadow_row(connp->shadow.trn, grid->y) + grid->x;
+
+        scr->a = a;
+        scr->c = c;
+        if (p->use_graphics)
+        {
+            trn->a = ta;
+            trn->c = tc;
+        }
     }
-    return Packet_printf(&connp->c, "%b%b%b%hu%c", (unsigned)PKT_CHAR, (unsigned)grid->x,
-        (unsigned)grid->y, (unsigned)a, (int)c);
+
+    Conn_count_output(connp);
+    return write_char(&connp->c, grid, a, c, ta, tc,
+        p->use_graphics && (p->remote_term == NTERM_WIN_OVERHEAD));
 }
 
 
@@ -2872,6 +3753,9 @@ int Send_mini_map(struct player *p, int y, int16_t w)
     /* Packet header */
     Packet_printf(&connp->c, "%b%hd%hd", (unsigned)PKT_MINI_MAP, y, (int)w);
 
+    /* The mini map overwrites the main map on the client */
+    shadow_invalidate(connp, -1);
+
     /* Reset the line counter */
     if (y == -1) return 1;
 
@@ -2933,11 +3817,21 @@ int Send_pause(struct player *p)
 
 int Send_monster_health(struct player *p, int num, uint8_t attr)
 {
+    sockbuf_t *slot;
+    char *ptr;
+
     connection_t *connp = get_connp(p, "monster health");
     if (connp == NULL) return 0;
 
-    return Packet_printf(&connp->c, "%b%c%b", (unsigned)PKT_MONSTER_HEALTH,
-        num, (unsigned)attr);
+    slot = get_slot(connp, SLOT_MONSTER_HEALTH);
+    ptr = Packet_reserve(slot, 3);
+    if (!ptr) return -1;
+
+    ptr = Packet_put_byte(ptr, PKT_MONSTER_HEALTH);
+    ptr = Packet_put_char(ptr, (char)num);
+    ptr = Packet_put_byte(ptr, attr);
+
+    return Packet_commit(slot, ptr);
 }
 
 
@@ -3058,6 +3952,9 @@ int Send_term_info(struct player *p, int mode, uint16_t arg)
     {
         if (p->remote_term == (uint8_t)arg) return 1;
         p->remote_term = (uint8_t)arg;
+
+        /* The main map will be redrawn from scratch */
+        shadow_invalidate(connp, -1);
     }
 
     return Packet_printf(&connp->c, "%b%c%hu", (unsigned)PKT_TERM, mode, (unsigned)arg);
@@ -3087,6 +3984,8 @@ int Send_play(int ind)
 {
     connection_t *connp = get_connection(ind);
 
+    Conn_count_output(connp);
+
     if (connp->state != CONN_SETUP)
     {
         errno = 0;
@@ -3102,6 +4001,8 @@ int Send_features(int ind, int lighting, int off)
 {
     connection_t *connp = get_connection(ind);
 
+    Conn_count_output(connp);
+
     if (Packet_printf(&connp->c, "%b%hd%hd", (unsigned)PKT_FEATURES, lighting, off) <= 0)
     {
         Destroy_connection(ind, "Send_features write error");
@@ -3112,12 +4013,103 @@ int Send_features(int ind, int lighting, int off)
 }
 
 
+/*
+ * Struct info blocks that clients can cache
+ */
+static const struct
+{
+    int type;
+    int (*send_info)(int ind);
+} struct_blocks[] =
+{
+    {STRUCT_INFO_LIMITS, Send_limits_struct_info},
+    {STRUCT_INFO_KINDS, Send_kind_struct_info},
+    {STRUCT_INFO_EGOS, Send_ego_struct_info},
+    {STRUCT_INFO_RACE, Send_race_struct_info},
+    {STRUCT_INFO_REALM, Send_realm_struct_info},
+    {STRUCT_INFO_CLASS, Send_class_struct_info},
+    {STRUCT_INFO_BODY, Send_body_struct_info},
+    {STRUCT_INFO_SOCIALS, Send_socials_struct_info},
+    {STRUCT_INFO_RINFO, Send_rinfo_struct_info},
+    {STRUCT_INFO_RBINFO, Send_rbinfo_struct_info},
+    {STRUCT_INFO_CURSES, Send_curse_struct_info},
+    {STRUCT_INFO_FEAT, Send_feat_struct_info},
+    {STRUCT_INFO_TRAP, Send_trap_struct_info},
+    {STRUCT_INFO_TIMED, Send_timed_struct_info},
+    {STRUCT_INFO_PROPS, Send_abilities_struct_info}
+};
+
+
+/*
+ * Compute the digest of every struct info block, so that the first clients
+ * to log in can already use their cache. The blocks are written to the
+ * connection buffer and taken back.
+ */
+static void hash_struct_info(int ind)
+{
+    connection_t *connp = get_connection(ind);
+    size_t i;
+
+    Conn_count_output(connp);
+    for (i = 0; i < N_ELEMENTS(struct_blocks); i++)
+    {
+        char *digest = struct_digest[struct_blocks[i].type];
+        int start = connp->c.len;
+
+        if (digest[0]) continue;
+        if (struct_blocks[i].send_info(ind) <= 0) return;
+        MD5Digest(connp->c.buf + start, connp->c.len - start, digest);
+        connp->c.len = connp->pkt_mark = start;
+    }
+}
+
+
+/*
+ * Send a struct info block, or only its digest if the client has it cached
+ */
+static void Send_struct_info_cached(int ind, int type, int (*send_info)(int))
+{
+    connection_t *connp = get_connection(ind);
+    char *digest = struct_digest[type];
+    int i, start = connp->c.len;
+
+    if (connp->state != CONN_SETUP) return;
+    Conn_count_output(connp);
+
+    /* The client has this block already */
+    for (i = 0; digest[0] && (i < connp->struct_cache_num); i++)
+    {
+        if (streq(connp->struct_cache[i], digest))
+        {
+            if (Packet_printf(&connp->c, "%b%c%s", (unsigned)PKT_STRUCT_CACHED, type, digest) <= 0)
+                Destroy_connection(ind, "Send_struct_info_cached write error");
+            return;
+        }
+    }
+
+    if (send_info(ind) <= 0) return;
+
+    /* The block only depends on the game data */
+    if (!digest[0]) MD5Digest(connp->c.buf + start, connp->c.len - start, digest);
+
+    /* Tell the client under which digest to keep it */
+    Conn_count_output(connp);
+    if ((connp->version >= STRUCT_CACHE_VERSION) &&
+        (Packet_printf(&connp->c, "%b%c%s", (unsigned)PKT_STRUCT_DIGEST, type, digest) <= 0))
+    {
+        Destroy_connection(ind, "Send_struct_info_cached write error");
+    }
+}
+
+
 int Send_text_screen(int ind, int type, int32_t offset)
 {
     connection_t *connp = get_connection(ind);
-    int i;
+    int i, start = connp->c.len;
     int32_t max;
 
+    Conn_count_output(connp);
+
     max = MAX_TEXTFILE_CHUNK;
     if (offset + max > TEXTFILE__WID * TEXTFILE__HGT) max = TEXTFILE__WID * TEXTFILE__HGT - offset;
     if (offset > TEXTFILE__WID * TEXTFILE__HGT) offset = TEXTFILE__WID * TEXTFILE__HGT;
@@ -3137,6 +4129,8 @@ int Send_text_screen(int ind, int type, int32_t offset)
         }
     }
 
+    Conn_compress_setup(connp, start);
+
     return 1;
 }
 
@@ -3145,6 +4139,8 @@ int Send_char_info_conn(int ind)
 {
     connection_t *connp = get_connection(ind);
 
+    Conn_count_output(connp);
+
     if (connp->state != CONN_SETUP)
     {
         errno = 0;
@@ -3172,6 +4168,8 @@ int Send_birth_options(int ind, struct birth_options *options)
 {
     connection_t *connp = get_connection(ind);
 
+    Conn_count_output(connp);
+
     if (connp->state != CONN_SETUP)
     {
         errno = 0;
@@ -3214,11 +4212,15 @@ bool Send_dump_character(connection_t *connp, const char *dumpname, int mode)
         case 1: tok = "BEGIN_NORMAL_DUMP"; break;
         case 2: tok = "BEGIN_MANUAL_DUMP"; break;
     }
+    Conn_count_output(connp);
     Packet_printf(&connp->c, "%b%s", (unsigned)PKT_CHAR_DUMP, tok);
 
     /* Process the file */
     while (file_getl(fp, buf, sizeof(buf)))
+    {
+        Conn_count_output(connp);
         Packet_printf(&connp->c, "%b%s", (unsigned)PKT_CHAR_DUMP, buf);
+    }
 
     /* End sending */
     switch (mode)
@@ -3226,6 +4228,7 @@ bool Send_dump_character(connection_t *connp, const char *dumpname, int mode)
         case 1: tok = "END_NORMAL_DUMP"; break;
         case 2: tok = "END_MANUAL_DUMP"; break;
     }
+    Conn_count_output(connp);
     Packet_printf(&connp->c, "%b%s", (unsigned)PKT_CHAR_DUMP, tok);
 
     /* Close the file */
@@ -3335,6 +4338,9 @@ int Send_fullmap(struct player *p, int y)
     /* Packet header */
     Packet_printf(&connp->c, "%b%hd", (unsigned)PKT_FULLMAP, y);
 
+    /* The full map overwrites the main map on the client */
+    shadow_invalidate(connp, -1);
+
     /* Reset the line counter */
     if (y == -1) return 1;
 
@@ -5197,6 +6203,9 @@ static int Receive_redraw(int ind)
         /* Break mind link */
         break_mind_link(p);
 
+        /* The client may have lost its screen */
+        shadow_invalidate(connp, -1);
+
         do_cmd_redraw(p);
     }
 
@@ -6518,6 +7527,9 @@ static int Enter_player(int ind)
 
     NumPlayers++;
 
+    /* Player is now on the level */
+    chunk_roster_add(p);
+
     connp->id = NumConnections;
     set_player_index(connp, NumPlayers);
 
@@ -6919,6 +7931,16 @@ static int Receive_play(int ind)
             return -1;
         }
 
+        /* Ask the client which struct info it has cached */
+        Conn_count_output(connp);
+        if ((connp->version >= STRUCT_CACHE_VERSION) &&
+            (Packet_printf(&connp->c, "%b", (unsigned)PKT_STRUCT_CACHE) <= 0))
+        {
+            Destroy_connection(ind, "play_setup write error");
+            return -1;
+        }
+
+        Conn_count_output(connp);
         if (Packet_printf(&connp->c, "%b%b", (unsigned)PKT_PLAY_SETUP, (unsigned)chardump) <= 0)
         {
             Destroy_connection(ind, "play_setup write error");
@@ -6931,18 +7953,21 @@ static int Receive_play(int ind)
     /* Send struct info (part 1) */
     if (phase == 1)
     {
+        int start = connp->c.len;
+
         Send_basic_info(ind);
-        Send_limits_struct_info(ind);
-        Send_kind_struct_info(ind);
-        Send_ego_struct_info(ind);
-        Send_race_struct_info(ind);
-        Send_realm_struct_info(ind);
-        Send_class_struct_info(ind);
-        Send_body_struct_info(ind);
-        Send_socials_struct_info(ind);
-        Send_rinfo_struct_info(ind);
-        Send_rbinfo_struct_info(ind);
-        Send_curse_struct_info(ind);
+        Send_struct_info_cached(ind, STRUCT_INFO_LIMITS, Send_limits_struct_info);
+        Send_struct_info_cached(ind, STRUCT_INFO_KINDS, Send_kind_struct_info);
+        Send_struct_info_cached(ind, STRUCT_INFO_EGOS, Send_ego_struct_info);
+        Send_struct_info_cached(ind, STRUCT_INFO_RACE, Send_race_struct_info);
+        Send_struct_info_cached(ind, STRUCT_INFO_REALM, Send_realm_struct_info);
+        Send_struct_info_cached(ind, STRUCT_INFO_CLASS, Send_class_struct_info);
+        Send_struct_info_cached(ind, STRUCT_INFO_BODY, Send_body_struct_info);
+        Send_struct_info_cached(ind, STRUCT_INFO_SOCIALS, Send_socials_struct_info);
+        Send_struct_info_cached(ind, STRUCT_INFO_RINFO, Send_rinfo_struct_info);
+        Send_struct_info_cached(ind, STRUCT_INFO_RBINFO, Send_rbinfo_struct_info);
+        Send_struct_info_cached(ind, STRUCT_INFO_CURSES, Send_curse_struct_info);
+        Conn_compress_setup(connp, start);
 
         return 2;
     }
@@ -6950,7 +7975,10 @@ static int Receive_play(int ind)
     /* Send feat info */
     if (phase == 2)
     {
-        Send_feat_struct_info(ind);
+        int start = connp->c.len;
+
+        Send_struct_info_cached(ind, STRUCT_INFO_FEAT, Send_feat_struct_info);
+        Conn_compress_setup(connp, start);
 
         return 2;
     }
@@ -6958,10 +7986,20 @@ static int Receive_play(int ind)
     /* Send struct info (part 2) */
     if (phase == 3)
     {
-        Send_trap_struct_info(ind);
-        Send_timed_struct_info(ind);
-        Send_abilities_struct_info(ind);
+        int start = connp->c.len;
+
+        Send_struct_info_cached(ind, STRUCT_INFO_TRAP, Send_trap_struct_info);
+        Send_struct_info_cached(ind, STRUCT_INFO_TIMED, Send_timed_struct_info);
+        Send_struct_info_cached(ind, STRUCT_INFO_PROPS, Send_abilities_struct_info);
         Send_char_info_conn(ind);
+        Conn_compress_setup(connp, start);
+
+        /* Report how much setup data this login took */
+        if (connp->state == CONN_SETUP)
+        {
+            plog_fmt("Setup data for %s: %ld bytes sent (%ld uncompressed)", connp->nick,
+                connp->setup_sent, connp->setup_bytes);
+        }
 
         return 2;
     }
@@ -7001,6 +8039,51 @@ static int Receive_quit(int ind)
 }
 
 
+static int Receive_struct_cache(int ind)
+{
+    connection_t *connp = get_connection(ind);
+    int n, i;
+    uint8_t ch;
+    int16_t num;
+    char digest[NORMAL_WID];
+    char (*cache)[MD5_HEX_SIZE];
+
+    if ((n = Packet_scanf(&connp->r, "%b%hd", &ch, &num)) <= 0)
+    {
+        if (n == -1) Destroy_connection(ind, "Receive_struct_cache read error");
+        return n;
+    }
+
+    /* Paranoia */
+    if ((num < 0) || (num > STRUCT_CACHE_MAX))
+    {
+        Destroy_connection(ind, "Receive_struct_cache read error");
+        return -1;
+    }
+
+    cache = mem_zalloc((num + 1) * sizeof(*cache));
+    for (i = 0; i < num; i++)
+    {
+        if ((n = Packet_scanf(&connp->r, "%s", digest)) <= 0)
+        {
+            mem_free(cache);
+            if (n == -1) Destroy_connection(ind, "Receive_struct_cache read error");
+            return n;
+        }
+        my_strcpy(cache[i], digest, MD5_HEX_SIZE);
+    }
+
+    mem_free(connp->struct_cache);
+    connp->struct_cache = cache;
+    connp->struct_cache_num = num;
+
+    /* Make sure we know what to compare with */
+    if (num) hash_struct_info(ind);
+
+    return 2;
+}
+
+
 static int Receive_text_screen(int ind)
 {
     connection_t *connp = get_connection(ind);
@@ -7040,6 +8123,7 @@ static int Receive_keepalive(int ind)
         if (n == -1) Destroy_connection(ind, "Keepalive read error");
         return n;
     }
+    Conn_count_output(connp);
     Packet_printf(&connp->c, "%b%ld", (unsigned)PKT_KEEPALIVE, ctime);
 
     return 2;
@@ -7082,6 +8166,9 @@ static int sync_settings(struct player *p)
 {
     connection_t *connp = get_connection(p->conn);
 
+    /* The client redraws its map after changing its settings */
+    shadow_invalidate(connp, -1);
+
     /* Resize */
     if ((connp->Client_setup.settings[SETTING_SCREEN_COLS] != p->screen_cols) ||
         (connp->Client_setup.settings[SETTING_SCREEN_ROWS] != p->screen_rows))
@@ -7171,6 +8258,7 @@ static int Receive_options(int ind)
         /* Set new values */
         for (i = 0; i < OPT_MAX; i++)
             p->opts.opt[i] = connp->options[i];
+        p->upkeep->dirty = true;
 
         /* Update birth options */
         update_birth_options(p, &options, true);
@@ -7664,6 +8752,7 @@ static int Receive_purchase(int ind)
             else
                 do_cmd_retrieve(p, item, amt);
 
+            Conn_count_output(connp);
             Packet_printf(&connp->c, "%b", (unsigned)PKT_PURCHASE);
         }
         else
@@ -7798,6 +8887,7 @@ static int Receive_store_confirm(int ind)
         if (in_store(p))
         {
             store_confirm(p);
+            Conn_count_output(connp);
             Packet_printf(&connp->c, "%b", (unsigned)PKT_STORE_CONFIRM);
         }
         else if (p->current_house != -1)
@@ -7919,6 +9009,7 @@ static int Receive_ignore(int ind)
             if (new_ignore_level[i] > p->opts.ignore_lvl[i]) ignore = true;
             p->opts.ignore_lvl[i] = new_ignore_level[i];
         }
+        p->upkeep->dirty = true;
     }
 
     /* Notice and redraw as needed */
@@ -8079,6 +9170,44 @@ static const receive_handler_f playing_receive[] =
 };
 
 
+/*
+ * Dispatch a command to its Receive function, counting it if it was handled
+ */
+static int Conn_receive(int ind, const receive_handler_f *receive_tbl, int type)
+{
+    connection_t *connp = get_connection(ind);
+    char *start = connp->r.ptr;
+    int len = connp->r.len, result, n;
+    int64_t begin = sched_clock(), elapsed;
+
+    result = (*receive_tbl[type])(ind);
+    elapsed = sched_clock() - begin;
+
+    pkt_totals[type].handler_time += elapsed;
+    if (connp->pkt_stats) connp->pkt_stats[type].handler_time += elapsed;
+
+    /* Commands put back in the queue are counted when they are executed */
+    if (result <= 0) return result;
+
+    /*
+     * If more data was read meanwhile, what was left of the buffer moved to
+     * its start first
+     */
+    if (connp->r.len == len) n = connp->r.ptr - start;
+    else n = connp->r.ptr - connp->r.buf;
+
+    pkt_totals[type].recv++;
+    pkt_totals[type].recv_bytes += n;
+    if (connp->pkt_stats)
+    {
+        connp->pkt_stats[type].recv++;
+        connp->pkt_stats[type].recv_bytes += n;
+    }
+
+    return result;
+}
+
+
 /* Actually execute commands from the client command queue */
 bool process_pending_commands(int ind)
 {
@@ -8087,7 +9216,6 @@ bool process_pending_commands(int ind)
     int type, result, old_energy = 0;
     const receive_handler_f *receive_tbl;
     int num_players_start = NumPlayers;
-    int last_pos, data_advance = 0;
 
     /* Paranoia: ignore input from client if not in SETUP or PLAYING state */
     /*if ((connp->state != CONN_PLAYING) && (connp->state != CONN_SETUP)) return true;*/
@@ -8102,19 +9230,11 @@ bool process_pending_commands(int ind)
     /*
      * Take any pending commands from the command queue connp->q
      * and move them to connp->r, where the Receive functions get their
-     * data from.
+     * data from. The two buffers simply trade places, leaving an empty
+     * command queue.
      */
     Sockbuf_clear(&connp->r);
-    if (connp->q.len > 0)
-    {
-        if (Sockbuf_write(&connp->r, connp->q.ptr, connp->q.len) != connp->q.len)
-        {
-            errno = 0;
-            Destroy_connection(ind, "Can't copy queued data to buffer");
-            return true;
-        }
-        Sockbuf_clear(&connp->q);
-    }
+    Sockbuf_swap(&connp->r, &connp->q);
 
     /* If we have no commands to execute return */
     if (connp->r.len <= 0) return false;
@@ -8122,31 +9242,42 @@ bool process_pending_commands(int ind)
     /* If our player id has not been set then do WITHOUT player */
     if (connp->id == -1)
     {
+        /*
+         * A command that lacks bytes waits in the command queue for the rest
+         * of them, so the Receive functions must not read more data here
+         * (which would also move the data under our feet).
+         */
+        connp->r.state |= SOCKBUF_LOCK;
+        result = 1;
         while ((connp->r.ptr < connp->r.buf + connp->r.len))
         {
-            /* Store all data for future, incase a command reports it lacks bytes! */
-            if (Sockbuf_write(&connp->q, connp->r.ptr, (connp->r.len - data_advance)) !=
-                (connp->r.len - data_advance))
-            {
-                errno = 0;
-                Destroy_connection(ind, "Can't copy read data to queue buffer");
-                return true;
-            }
-            last_pos = (int)connp->r.ptr;
+            char *start = connp->r.ptr;
+
             type = (connp->r.ptr[0] & 0xFF);
 
             /* Paranoia */
             if ((type < PKT_UNDEFINED) || (type >= PKT_MAX)) type = PKT_UNDEFINED;
-            
-            result = (*receive_tbl[type])(ind);
-            data_advance += ((int)connp->r.ptr - last_pos);
+
+            result = Conn_receive(ind, receive_tbl, type);
             ht_copy(&connp->start, &turn);
-            if (result == 0) return true;
-            Sockbuf_clear(&connp->q);
-            if (result == -1) return true;
+            if (result == -1) break;
+
+            /* Store the command for future, since it reports it lacks bytes! */
+            if (result == 0)
+            {
+                int len = connp->r.buf + connp->r.len - start;
+
+                if (Sockbuf_write(&connp->q, start, len) != len)
+                {
+                    errno = 0;
+                    Destroy_connection(ind, "Can't copy read data to queue buffer");
+                }
+                break;
+            }
         }
+        connp->r.state &= ~SOCKBUF_LOCK;
 
-        return false;
+        return (result <= 0);
     }
 
     /* Get the player pointer */
@@ -8178,7 +9309,7 @@ bool process_pending_commands(int ind)
                 p->firing_request = false;
         }
 
-        result = (*receive_tbl[type])(ind);
+        result = Conn_receive(ind, receive_tbl, type);
         if (connp->state == CONN_PLAYING) ht_copy(&connp->start, &turn);
         if (result == -1) return true;
 
@@ -8235,6 +9366,11 @@ int Net_input(void)
     connection_t *connp;
     char msg[MSG_LEN];
 
+#ifdef USE_NET_THREAD
+    /* Pick up the input that couldn't be handled when it came in */
+    if (net_thread_running()) Net_thread_input();
+#endif
+
     for (i = 0; i < MAX_PLAYERS; i++)
     {
         connp = get_connection(i);
@@ -8255,6 +9391,15 @@ int Net_input(void)
             continue;
         }
 
+#ifdef USE_NET_THREAD
+        /* Feed the network thread what it has room for */
+        if (connp->out.head && net_thread_attached(i)) Conn_flush_output(i);
+#endif
+
+        /* Drop clients that stopped reading what we send them */
+        if ((connp->w.sock != -1) && connp->out.head && !Conn_check_backlog(i))
+            continue;
+
         /*
          * Make sure that the player we are looking at is not already in the
          * game. If he is already in the game then we will send him data
@@ -8297,12 +9442,20 @@ int Net_output_p(struct player *p)
 {
     connection_t *connp = get_connection(p->conn);
 
+    /* Add the final state of the supersedable packets for this frame */
+    if (Conn_flush_slots(connp) == -1)
+    {
+        Destroy_connection(p->conn, "Net output write error");
+        return 1;
+    }
+
     /*
      * If we have any data to send to the client, terminate it
      * and send it to the client.
      */
     if (connp->c.len > 0)
     {
+        Conn_count_output(connp);
         if (Packet_printf(&connp->c, "%b", (unsigned)PKT_END) <= 0)
         {
             Destroy_connection(p->conn, "Net output write error");
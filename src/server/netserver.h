@@ -28,6 +28,78 @@
 #define LINK_DOMINANT   1
 #define LINK_DOMINATED  2
 
+/*
+ * Outbound data that the kernel couldn't take yet, kept as a list of
+ * fixed-size chunks until the socket becomes writable again.
+ */
+#define OUT_CHUNK_SIZE  (16*1024)
+
+struct out_chunk
+{
+    struct out_chunk *next;
+    int start;                  /* first byte not yet sent */
+    int len;                    /* bytes used */
+    char data[OUT_CHUNK_SIZE];
+};
+
+struct out_queue
+{
+    struct out_chunk *head;
+    struct out_chunk *tail;
+    long bytes;                 /* bytes queued */
+    bool congested;             /* went above the high watermark */
+    hturn last_drain;           /* turn when the kernel last took data */
+};
+
+/*
+ * Packets that only matter for their latest value. Within a frame, each send
+ * overwrites the previous one in its slot, and only the last one is appended
+ * to the batch when it is terminated.
+ */
+enum
+{
+    SLOT_HP = 0,
+    SLOT_SP,
+    SLOT_STATUS,
+    SLOT_STATE,
+    SLOT_MONSTER_HEALTH,
+
+    SLOT_MAX
+};
+
+#define SLOT_SIZE   512
+
+/*
+ * What the client was last sent for each line of its main map, so that
+ * redraws only need to send the cells that changed (PKT_LINE_DELTA).
+ */
+struct map_shadow
+{
+    cave_view_type *scr;        /* attr/char stream, one row after the other */
+    cave_view_type *trn;        /* transparency attr/char stream */
+    bool *valid;                /* the client has this row */
+    int screen_wid;             /* layout the rows are valid for */
+    int tile_wid;
+    int tile_hgt;
+    bool graphics;
+};
+
+/*
+ * Traffic of one packet type. Sent packets are counted as written, before
+ * compression.
+ */
+struct pkt_stats
+{
+    uint32_t sent;              /* packets sent */
+    uint64_t sent_bytes;
+    uint32_t recv;              /* packets handled */
+    uint64_t recv_bytes;
+    int64_t handler_time;       /* time spent in the Receive_* function (ns) */
+};
+
+#define PACKET_STATS_HEADER \
+    "Packet                   Sent      Bytes   Received      Bytes  Time (ms)\n"
+
 typedef struct
 {
     int             state;
@@ -35,6 +107,15 @@ typedef struct
     sockbuf_t       w;
     sockbuf_t       c;
     sockbuf_t       q;
+    struct out_queue out;
+    sockbuf_t       slots[SLOT_MAX];
+    struct map_shadow shadow;
+    long            setup_bytes;    /* setup data, before compression */
+    long            setup_sent;     /* setup data, as sent */
+    char            (*struct_cache)[MD5_HEX_SIZE];  /* struct info the client has cached */
+    int             struct_cache_num;
+    struct pkt_stats *pkt_stats;    /* traffic per packet type */
+    int             pkt_mark;       /* first byte of "c" not counted yet */
     hturn           start;
     long            timeout;
     bool            has_setup;
@@ -97,6 +178,9 @@ extern void Conn_set_console_setting(int ind, int set, bool val);
 extern bool Conn_get_console_setting(int ind, int set);
 extern int Init_setup(void);
 extern uint8_t *Conn_get_console_channels(int ind);
+extern void Conn_get_queued(int ind, long *in, long *out);
+extern bool packet_stats_line(int ind, int type, char *buf, size_t len);
+extern void dump_packet_stats(void);
 
 /*** Sending ***/
 extern int Send_basic_info(int ind);
@@ -638,12 +638,14 @@ size_t object_desc(struct player *p, char *buf, size_t max, const struct object
     if (p && obj->known->ego && obj->ego && !p->ego_everseen[obj->ego->eidx])
     {
         p->ego_everseen[obj->ego->eidx] = 1;
+        p->upkeep->dirty = true;
         Send_ego_everseen(p, obj->ego->eidx);
     }
 
     if (p && aware && !p->kind_everseen[obj->kind->kidx])
     {
         p->kind_everseen[obj->kind->kidx] = 1;
+        p->upkeep->dirty = true;
         Send_everseen(p, obj->kind->kidx);
     }
 
@@ -1253,6 +1253,7 @@ static void player_learn_rune(struct player *p, size_t i, bool message)
 
     /* Nothing learned */
     if (!learned) return;
+    p->upkeep->dirty = true;
 
     /* Give a message */
     if (message) msgt(p, MSG_RUNE, "You have learned the rune of %s.", rune_name(i));
@@ -1990,6 +1991,7 @@ static void object_flavor_aware_aux(struct player *p, struct object *obj, bool s
 
     /* Fully aware of the effects */
     p->kind_aware[obj->kind->kidx] = true;
+    p->upkeep->dirty = true;
     if (send) Send_aware(p, obj->kind->kidx);
     apply_autoinscription(p, obj);
 
@@ -2050,6 +2052,7 @@ void object_flavor_tried(struct player *p, struct object *obj)
     if (obj->artifact) return;
 
     p->kind_tried[obj->kind->kidx] = true;
+    p->upkeep->dirty = true;
 }
 
 
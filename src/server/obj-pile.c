@@ -1015,6 +1015,7 @@ bool floor_carry(struct player *p, struct chunk *c, struct loc *grid, struct obj
 
     /* Fail if the square can't hold objects */
     if (!square_isobjectholding(c, grid)) return false;
+    c->modified = true;
 
     /* Scan objects in that grid for combination */
     for (obj = square_object(c, grid); obj; obj = obj->next)
@@ -968,20 +968,17 @@ void shimmer_objects(struct player *p, struct chunk *c)
  */
 void process_objects(struct chunk *c)
 {
-    int i;
+    struct player *p;
     struct loc begin, end;
     struct loc_iterator iter;
 
     /* Every 10 game turns */
     if ((turn.turn % 10) != 5) return;
 
-    /* Check everyone */
-    for (i = 1; i <= NumPlayers; i++)
+    /* Check everyone on the level */
+    for (p = c->players; p; p = p->roster_next)
     {
-        struct player *p = player_get(i);
-
         /* Skip irrelevant players */
-        if (!wpos_eq(&p->wpos, &c->wpos)) continue;
         if (p->upkeep->new_level_method || p->upkeep->funeral) continue;
         if (!allow_shimmer(p)) continue;
 
@@ -1006,13 +1003,19 @@ void process_objects(struct chunk *c)
             next = obj->next;
 
             /* Recharge rods */
-            if (tval_can_have_timeout(obj) && recharge_timeout(obj))
-                redraw = true;
+            if (tval_can_have_timeout(obj) && number_charging(obj))
+            {
+                if (recharge_timeout(obj)) redraw = true;
+
+                /* The timeout is saved with the level */
+                c->modified = true;
+            }
 
             /* Corpses slowly decompose */
             if (tval_is_corpse(obj))
             {
                 obj->decay--;
+                c->modified = true;
 
                 /* Notice changes */
                 if (obj->decay == obj->timeout / 5)
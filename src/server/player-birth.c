@@ -1297,6 +1297,9 @@ static void player_setup(struct player *p, int id, uint32_t account, bool deepto
 
     c = chunk_get(&p->wpos);
 
+    /* Bring back a level swapped out to disk */
+    if (!c) c = load_level(&p->wpos);
+
     /* Rebuild the level if necessary */
     if (!c)
     {
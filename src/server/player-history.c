@@ -83,6 +83,7 @@ void history_add_full(struct player *p, struct history_info *entry)
     memcpy(&h->entries[h->next], entry, sizeof(struct history_info));
 
     h->next++;
+    p->upkeep->dirty = true;
 }
 
 
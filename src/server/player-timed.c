@@ -1576,6 +1576,9 @@ bool player_set_timed(struct player *p, int idx, int v, bool notify)
     /* Food meter */
     if (idx == TMD_FOOD) food_meter = p->timed[idx] / 100;
 
+    /* Timed effects often change without a redraw, the savefile is out of date anyway */
+    if (p->timed[idx] != v) p->upkeep->dirty = true;
+
     /* Use the value */
     p->timed[idx] = v;
 
@@ -102,9 +102,11 @@ void dungeon_change_level(struct player *p, struct chunk *c, struct worldpos *ne
 
     /* Set coordinates */
     memcpy(&p->wpos, new_wpos, sizeof(struct worldpos));
+    p->upkeep->dirty = true;
 
     /* One more player here */
     chunk_increase_player_count(new_wpos);
+    chunk_roster_add(p);
 
     /* Generate a new level (later) */
     p->upkeep->new_level_method = new_level_method;
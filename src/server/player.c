@@ -1346,27 +1346,86 @@ void player_safe_name(char *safe, size_t safelen, const char *name)
 }
 
 
-void player_cave_new(struct player *p, int height, int width)
+/*
+ * Size of the storage for "n" squares of player map memory
+ *
+ * The squares come first, then the noise and scent heatmaps, then the info flags,
+ * so that the last three can be wiped with a single memset().
+ */
+static size_t player_cave_size(int n)
 {
-    struct loc grid;
+    return n * (sizeof(struct player_square) + 2 * sizeof(uint16_t) + SQUARE_SIZE * sizeof(bitflag));
+}
 
-    if (p->cave->allocated) player_cave_free(p);
 
-    p->cave->height = height;
-    p->cave->width = width;
+/*
+ * Forget the objects and traps remembered on the player map
+ */
+static void player_cave_forget(struct player *p)
+{
+    struct loc grid;
 
-    p->cave->squares = mem_zalloc(p->cave->height * sizeof(struct player_square*));
-    p->cave->noise.grids = mem_zalloc(p->cave->height * sizeof(uint16_t*));
-    p->cave->scent.grids = mem_zalloc(p->cave->height * sizeof(uint16_t*));
     for (grid.y = 0; grid.y < p->cave->height; grid.y++)
     {
-        p->cave->squares[grid.y] = mem_zalloc(p->cave->width * sizeof(struct player_square));
         for (grid.x = 0; grid.x < p->cave->width; grid.x++)
-            square_p(p, &grid)->info = mem_zalloc(SQUARE_SIZE * sizeof(bitflag));
-        p->cave->noise.grids[grid.y] = mem_zalloc(p->cave->width * sizeof(uint16_t));
-        p->cave->scent.grids[grid.y] = mem_zalloc(p->cave->width * sizeof(uint16_t));
+        {
+            square_forget_pile(p, &grid);
+            square_forget_trap(p, &grid);
+        }
+    }
+}
+
+
+/*
+ * Allocate the player map memory for a level
+ *
+ * The storage is a single block, which is kept when changing level and only
+ * reallocated when a bigger level comes.
+ */
+void player_cave_new(struct player *p, int height, int width)
+{
+    struct player_cave *cave = p->cave;
+    int i, n = height * width;
+    uint16_t *noise, *scent;
+    bitflag *info;
+
+    if (cave->allocated) player_cave_forget(p);
+
+    /* Get a bigger block */
+    if (n > cave->capacity)
+    {
+        mem_free(cave->block);
+        cave->block = mem_alloc(player_cave_size(n));
+        cave->capacity = n;
     }
-    p->cave->allocated = true;
+    if (height > cave->rows)
+    {
+        cave->noise.grids = mem_realloc(cave->noise.grids, height * sizeof(uint16_t*));
+        cave->scent.grids = mem_realloc(cave->scent.grids, height * sizeof(uint16_t*));
+        cave->rows = height;
+    }
+
+    cave->height = height;
+    cave->width = width;
+
+    /* Carve the block */
+    memset(cave->block, 0, player_cave_size(n));
+    cave->squares = cave->block;
+    noise = (uint16_t *)&cave->squares[n];
+    scent = &noise[n];
+    info = (bitflag *)&scent[n];
+    for (i = 0; i < height; i++)
+    {
+        cave->noise.grids[i] = &noise[i * width];
+        cave->scent.grids[i] = &scent[i * width];
+    }
+    for (i = 0; i < n; i++) cave->squares[i].info = &info[i * SQUARE_SIZE];
+
+    /* Nothing in view yet */
+    loc_init(&cave->view_begin, 0, 0);
+    loc_init(&cave->view_end, 0, 0);
+
+    cave->allocated = true;
 }
 
 
@@ -1397,6 +1456,7 @@ void init_player(struct player *p, int conn, bool old_history, bool deeptown, bo
 
     /* Allocate player sub-structs */
     p->upkeep = mem_zalloc(sizeof(struct player_upkeep));
+    p->upkeep->dirty = true;
     p->upkeep->inven = mem_zalloc((z_info->pack_size + 1) * sizeof(struct object *));
     p->upkeep->quiver = mem_zalloc(z_info->quiver_size * sizeof(struct object *));
     p->timed = mem_zalloc(TMD_MAX * sizeof(int16_t));
@@ -1668,29 +1728,17 @@ void cleanup_player(struct player *p)
 
 void player_cave_free(struct player *p)
 {
-    struct loc grid;
-
-    if (!p->cave->allocated) return;
+    if (p->cave->allocated) player_cave_forget(p);
 
-    for (grid.y = 0; grid.y < p->cave->height; grid.y++)
-    {
-        for (grid.x = 0; grid.x < p->cave->width; grid.x++)
-        {
-            mem_free(square_p(p, &grid)->info);
-            square_p(p, &grid)->info = NULL;
-            square_forget_pile(p, &grid);
-            square_forget_trap(p, &grid);
-        }
-        mem_free(p->cave->squares[grid.y]);
-        mem_free(p->cave->noise.grids[grid.y]);
-        mem_free(p->cave->scent.grids[grid.y]);
-    }
-    mem_free(p->cave->squares);
+    mem_free(p->cave->block);
+    p->cave->block = NULL;
     p->cave->squares = NULL;
+    p->cave->capacity = 0;
     mem_free(p->cave->noise.grids);
     p->cave->noise.grids = NULL;
     mem_free(p->cave->scent.grids);
     p->cave->scent.grids = NULL;
+    p->cave->rows = 0;
     p->cave->allocated = false;
 }
 
@@ -1725,26 +1773,24 @@ void player_cave_clear(struct player *p, bool full)
         /* Erase trap */
         square_forget_trap(p, &iter.cur);
 
-        /* Erase flags */
-        if (full)
-            sqinfo_wipe(square_p(p, &iter.cur)->info);
-        else
+        /* Erase flags (no bounds checking) */
+        if (!full)
         {
-            /* Erase flags (no bounds checking) */
             sqinfo_off(square_p(p, &iter.cur)->info, SQUARE_SEEN);
             sqinfo_off(square_p(p, &iter.cur)->info, SQUARE_VIEW);
             sqinfo_off(square_p(p, &iter.cur)->info, SQUARE_DTRAP);
         }
-
-        /* Erase flow */
-        if (full)
-        {
-            p->cave->noise.grids[iter.cur.y][iter.cur.x] = 0;
-            p->cave->scent.grids[iter.cur.y][iter.cur.x] = 0;
-        }
     }
     while (loc_iterator_next_strict(&iter));
 
+    /* Erase flow and flags (heatmaps and info flags are contiguous) */
+    if (full)
+    {
+        int n = p->cave->height * p->cave->width;
+
+        memset(p->cave->noise.grids[0], 0, n * (2 * sizeof(uint16_t) + SQUARE_SIZE * sizeof(bitflag)));
+    }
+
     /* Memorize the content of owned houses */
     memorize_houses(p);
 }
@@ -2406,6 +2406,9 @@ void monster_set_master(struct monster *mon, struct player *p, uint8_t status)
 
     if (p && (mon->status <= MSTATUS_SUMMONED)) p->slaves++;
     mon->status = status;
+
+    /* Pets are not threats */
+    update_mon_threats(mon);
 }
 
 
@@ -54,6 +54,7 @@
 #include "mon-summon.h"
 #include "mon-timed.h"
 #include "mon-util.h"
+#include "net-thread.h"
 #include "netserver.h"
 #include "object.h"
 #include "obj-chest.h"
@@ -151,8 +151,7 @@ static void wr_item(struct object *obj)
 
     wr_byte(obj->notice);
 
-    for (i = 0; i < OF_SIZE; i++)
-        wr_byte(obj->flags[i]);
+    wr_bytes(obj->flags, OF_SIZE);
 
     for (i = 0; i < OBJ_MOD_MAX; i++)
         wr_s32b(obj->modifiers[i]);
@@ -228,7 +227,6 @@ void wr_monster_memory(void *data)
     wr_byte(z_info->mon_blows_max);
     for (r = 0; r < z_info->r_max; r++)
     {
-        unsigned i;
         struct monster_race *race = &r_info[r];
         struct monster_lore* lore = (p? get_lore(p, race): &race->lore);
 
@@ -251,11 +249,11 @@ void wr_monster_memory(void *data)
         wr_byte(lore->cast_spell);
 
         /* Count blows of each type */
-        for (i = 0; i < (unsigned)z_info->mon_blows_max; i++) wr_byte(lore->blows[i]);
+        wr_bytes(lore->blows, z_info->mon_blows_max);
 
         /* Memorize flags */
-        for (i = 0; i < RF_SIZE; i++) wr_byte(lore->flags[i]);
-        for (i = 0; i < RSF_SIZE; i++) wr_byte(lore->spell_flags[i]);
+        wr_bytes(lore->flags, RF_SIZE);
+        wr_bytes(lore->spell_flags, RSF_SIZE);
     }
 }
 
@@ -307,7 +305,7 @@ void wr_object_memory(void *data)
             if (p->ego_ignore_types[i][j]) itype_on(itypes, j);
         }
 
-        for (j = 0; j < ITYPE_SIZE; j++) wr_byte(itypes[j]);
+        wr_bytes(itypes, ITYPE_SIZE);
     }
 }
 
@@ -319,7 +317,7 @@ void wr_player_artifacts(void *data)
 
     /* Write the artifact sold list */
     wr_u16b(z_info->a_max);
-    for (i = 0; i < z_info->a_max; i++) wr_byte(p->art_info[i]);
+    wr_bytes(p->art_info, z_info->a_max);
 
     /* Write the randart info */
     for (i = 0; i < z_info->a_max + 9; i++)
@@ -433,12 +431,11 @@ void wr_player(void *data)
 void wr_ignore(void *data)
 {
     struct player *p = (struct player *)data;
-    size_t i;
 
     /* Write number of ignore bytes */
     wr_byte(ITYPE_MAX);
 
-    for (i = ITYPE_NONE; i < ITYPE_MAX; i++) wr_byte(p->opts.ignore_lvl[i]);
+    wr_bytes(p->opts.ignore_lvl, ITYPE_MAX);
 }
 
 
@@ -513,8 +510,7 @@ void wr_player_misc(void *data)
     /* Property knowledge */
 
     /* Flags */
-    for (i = 0; i < OF_SIZE; i++)
-        wr_byte(p->obj_k->flags[i]);
+    wr_bytes(p->obj_k->flags, OF_SIZE);
 
     /* Modifiers */
     for (i = 0; i < OBJ_MOD_MAX; i++)
@@ -574,20 +570,19 @@ void wr_player_hp(void *data)
 void wr_player_spells(void *data)
 {
     struct player *p = (struct player *)data;
-    int i;
 
     /* Write spell data */
     wr_u16b(p->clazz->magic.total_spells);
-    for (i = 0; i < p->clazz->magic.total_spells; i++) wr_byte(p->spell_flags[i]);
+    wr_bytes(p->spell_flags, p->clazz->magic.total_spells);
 
     /* Dump the ordered spells */
-    for (i = 0; i < p->clazz->magic.total_spells; i++) wr_byte(p->spell_order[i]);
+    wr_bytes(p->spell_order, p->clazz->magic.total_spells);
 
     /* Dump spell power */
-    for (i = 0; i < p->clazz->magic.total_spells; i++) wr_byte(p->spell_power[i]);
+    wr_bytes(p->spell_power, p->clazz->magic.total_spells);
 
     /* Dump spell cooldown */
-    for (i = 0; i < p->clazz->magic.total_spells; i++) wr_byte(p->spell_cooldown[i]);
+    wr_bytes(p->spell_cooldown, p->clazz->magic.total_spells);
 }
 
 
@@ -888,10 +883,27 @@ void wr_level(void *data)
 }
 
 
+static void wr_level_aux(struct chunk *c)
+{
+    wr_level((void *)&c->wpos);
+}
+
+
+/*
+ * Tell if a level goes in the savefile being written: the level itself for its own
+ * savefile, the levels that aren't saved apart for the server savefile.
+ */
+static bool level_saved_here(struct chunk *c, void *data)
+{
+    if (data) return (c == (struct chunk *)data);
+    return (c && level_keep_allocated(c) && !level_saved_apart(&c->wpos));
+}
+
+
 /*
  * Write the current dungeon
  */
-void wr_dungeon(void *unused)
+void wr_dungeon(void *data)
 {
     int i;
     struct loc grid;
@@ -911,7 +923,7 @@ void wr_dungeon(void *unused)
                 struct chunk *c = w_ptr->chunk_list[i];
 
                 /* Make sure the level has been allocated */
-                if (c && level_keep_allocated(c)) tmp32u++;
+                if (level_saved_here(c, data)) tmp32u++;
             }
         }
     }
@@ -931,8 +943,8 @@ void wr_dungeon(void *unused)
             {
                 struct chunk *c = w_ptr->chunk_list[i];
 
-                if (c && level_keep_allocated(c))
-                    wr_level((void *)&c->wpos);
+                if (level_saved_here(c, data))
+                    wr_level_part(c, LEVEL_PART_DUNGEON, wr_level_aux);
             }
         }
     }
@@ -949,8 +961,14 @@ void wr_dungeon(void *unused)
             for (i = 0; i <= w_ptr->max_depth - w_ptr->min_depth; i++)
             {
                 struct chunk *c = w_ptr->chunk_list[i];
+                uint16_t mon_max;
 
-                if (c) compact_monsters(c, 0);
+                if (!c || (data && (c != data))) continue;
+
+                /* Compacting moves monsters around, the saved list is stale then */
+                mon_max = c->mon_max;
+                compact_monsters(c, 0);
+                if (c->mon_max != mon_max) c->modified = true;
             }
         }
     }
@@ -965,6 +983,11 @@ static void wr_objects_aux(struct chunk *c)
     struct loc begin, end;
     struct loc_iterator iter;
 
+    /* Write the coordinates */
+    wr_s16b(c->wpos.grid.y);
+    wr_s16b(c->wpos.grid.x);
+    wr_s16b(c->wpos.depth);
+
     loc_init(&begin, 0, 0);
     loc_init(&end, c->width, c->height);
     loc_iterator_first(&iter, &begin, &end);
@@ -1026,7 +1049,7 @@ void wr_player_objects(void *data)
 }
 
 
-void wr_objects(void *unused)
+void wr_objects(void *data)
 {
     int i;
     struct loc grid;
@@ -1044,7 +1067,7 @@ void wr_objects(void *unused)
                 struct chunk *c = w_ptr->chunk_list[i];
 
                 /* Make sure the level has been allocated */
-                if (c && level_keep_allocated(c)) tmp32u++;
+                if (level_saved_here(c, data)) tmp32u++;
             }
         }
     }
@@ -1063,15 +1086,8 @@ void wr_objects(void *unused)
             {
                 struct chunk *c = w_ptr->chunk_list[i];
 
-                if (c && level_keep_allocated(c))
-                {
-                    /* Write the coordinates */
-                    wr_s16b(c->wpos.grid.y);
-                    wr_s16b(c->wpos.grid.x);
-                    wr_s16b(c->wpos.depth);
-
-                    wr_objects_aux(c);
-                }
+                if (level_saved_here(c, data))
+                    wr_level_part(c, LEVEL_PART_OBJECTS, wr_objects_aux);
             }
         }
     }
@@ -1103,11 +1119,8 @@ static void wr_monster(const struct monster *mon)
     for (j = 0; j < MON_TMD_MAX; j++)
         wr_s16b(mon->m_timed[j]);
 
-    for (j = 0; j < MFLAG_SIZE; j++)
-        wr_byte(mon->mflag[j]);
-
-    for (j = 0; j < OF_SIZE; j++)
-        wr_byte(mon->known_pstate.flags[j]);
+    wr_bytes(mon->mflag, MFLAG_SIZE);
+    wr_bytes(mon->known_pstate.flags, OF_SIZE);
 
     for (j = 0; j < ELEM_MAX; j++)
         wr_s16b(mon->known_pstate.el_info[j].res_level[0]);
@@ -1167,6 +1180,11 @@ static void wr_monsters_aux(struct chunk *c)
     int i;
     uint16_t limit = 1;
 
+    /* Write the coordinates */
+    wr_s16b(c->wpos.grid.y);
+    wr_s16b(c->wpos.grid.x);
+    wr_s16b(c->wpos.depth);
+
     /* Total monsters */
     for (i = 1; i < cave_monster_max(c); i++)
     {
@@ -1189,7 +1207,7 @@ static void wr_monsters_aux(struct chunk *c)
 }
 
 
-void wr_monsters(void *unused)
+void wr_monsters(void *data)
 {
     int i;
     struct loc grid;
@@ -1209,7 +1227,7 @@ void wr_monsters(void *unused)
                 struct chunk *c = w_ptr->chunk_list[i];
 
                 /* Make sure the level has been allocated */
-                if (c && level_keep_allocated(c)) tmp32u++;
+                if (level_saved_here(c, data)) tmp32u++;
             }
         }
     }
@@ -1228,15 +1246,8 @@ void wr_monsters(void *unused)
             {
                 struct chunk *c = w_ptr->chunk_list[i];
 
-                if (c && level_keep_allocated(c))
-                {
-                    /* Write the coordinates */
-                    wr_s16b(c->wpos.grid.y);
-                    wr_s16b(c->wpos.grid.x);
-                    wr_s16b(c->wpos.depth);
-
-                    wr_monsters_aux(c);
-                }
+                if (level_saved_here(c, data))
+                    wr_level_part(c, LEVEL_PART_MONSTERS, wr_monsters_aux);
             }
         }
     }
@@ -1258,16 +1269,13 @@ static void wr_trap_kind(struct trap_kind *kind)
  */
 static void wr_trap(struct trap *trap)
 {
-    size_t i;
-
     wr_trap_kind(trap->kind);
     wr_byte(trap->grid.y);
     wr_byte(trap->grid.x);
     wr_byte(trap->power);
     wr_byte(trap->timeout);
 
-    for (i = 0; i < TRF_SIZE; i++)
-        wr_byte(trap->flags[i]);
+    wr_bytes(trap->flags, TRF_SIZE);
 }
 
 
@@ -1337,7 +1345,7 @@ static void wr_level_traps(struct chunk *c)
 }
 
 
-void wr_traps(void *unused)
+void wr_traps(void *data)
 {
     int i;
     struct loc grid;
@@ -1357,7 +1365,7 @@ void wr_traps(void *unused)
                 struct chunk *c = w_ptr->chunk_list[i];
 
                 /* Make sure the level has been allocated */
-                if (c && level_keep_allocated(c)) tmp32u++;
+                if (level_saved_here(c, data)) tmp32u++;
             }
         }
     }
@@ -1376,7 +1384,73 @@ void wr_traps(void *unused)
             {
                 struct chunk *c = w_ptr->chunk_list[i];
 
-                if (c && level_keep_allocated(c)) wr_level_traps(c);
+                if (level_saved_here(c, data))
+                    wr_level_part(c, LEVEL_PART_TRAPS, wr_level_traps);
+            }
+        }
+    }
+}
+
+
+/*
+ * Tell if a static level lives in its own savefile
+ */
+static bool level_in_own_file(struct worldpos *wpos)
+{
+    if (!chunk_has_players(wpos) || !level_saved_apart(wpos)) return false;
+    return (chunk_get(wpos) || chunk_on_disk(wpos));
+}
+
+
+/*
+ * Write the player count of the static levels saved in their own file
+ */
+void wr_levels(void *unused)
+{
+    int depth;
+    struct loc grid;
+    uint32_t tmp32u = 0;
+
+    /* Get the number of levels to dump */
+    for (grid.y = radius_wild; grid.y >= 0 - radius_wild; grid.y--)
+    {
+        for (grid.x = 0 - radius_wild; grid.x <= radius_wild; grid.x++)
+        {
+            struct wild_type *w_ptr = get_wt_info_at(&grid);
+
+            for (depth = 0; depth < w_ptr->max_depth; depth++)
+            {
+                struct worldpos wpos;
+
+                if (depth && (depth < w_ptr->min_depth)) continue;
+                wpos_init(&wpos, &grid, depth);
+                if (level_in_own_file(&wpos)) tmp32u++;
+            }
+        }
+    }
+
+    /* Write the number of levels */
+    wr_u32b(tmp32u);
+
+    /* Write the levels */
+    for (grid.y = radius_wild; grid.y >= 0 - radius_wild; grid.y--)
+    {
+        for (grid.x = 0 - radius_wild; grid.x <= radius_wild; grid.x++)
+        {
+            struct wild_type *w_ptr = get_wt_info_at(&grid);
+
+            for (depth = 0; depth < w_ptr->max_depth; depth++)
+            {
+                struct worldpos wpos;
+
+                if (depth && (depth < w_ptr->min_depth)) continue;
+                wpos_init(&wpos, &grid, depth);
+                if (!level_in_own_file(&wpos)) continue;
+
+                wr_s16b(wpos.grid.y);
+                wr_s16b(wpos.grid.x);
+                wr_s16b(wpos.depth);
+                wr_s16b(chunk_get_player_count(&wpos));
             }
         }
     }
@@ -1387,7 +1461,6 @@ void wr_history(void *data)
 {
     struct player *p = (struct player *)data;
     int i;
-    unsigned j;
 
     wr_byte(HIST_SIZE);
 
@@ -1395,7 +1468,7 @@ void wr_history(void *data)
     wr_s16b(p->hist.next);
     for (i = 0; i < p->hist.next; i++)
     {
-        for (j = 0; j < HIST_SIZE; j++) wr_byte(p->hist.entries[i].type[j]);
+        wr_bytes(p->hist.entries[i].type, HIST_SIZE);
         wr_hturn(&p->hist.entries[i].turn);
         wr_s16b(p->hist.entries[i].dlev);
         wr_s16b(p->hist.entries[i].clev);
@@ -19,6 +19,10 @@
 
 
 #include "s-angband.h"
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#include <signal.h>
+#endif
 
 
 /*
@@ -144,6 +148,7 @@ static const savefile_saver server_savers[] =
     {"objects", wr_objects, 1},
     {"monsters", wr_monsters, 1},
     {"traps", wr_traps, 1},
+    {"levels", wr_levels, 1},
 
     /* PWMAngband */
     {"parties", wr_parties, 1},
@@ -160,6 +165,16 @@ static const savefile_saver special_savers[] =
 };
 
 
+/* Savefile saving functions (static level saved in its own file) */
+static const savefile_saver level_savers[] =
+{
+    {"dungeons", wr_dungeon, 1},
+    {"objects", wr_objects, 1},
+    {"monsters", wr_monsters, 1},
+    {"traps", wr_traps, 1}
+};
+
+
 /* Savefile saving functions (account) */
 static const savefile_saver account_savers[] =
 {
@@ -210,6 +225,7 @@ static const struct blockinfo server_loaders[] =
     {"objects", rd_objects, 1},
     {"monsters", rd_monsters, 1},
     {"traps", rd_traps, 1},
+    {"levels", rd_levels, 1},
 
     /* PWMAngband */
     {"parties", rd_parties, 1},
@@ -228,6 +244,16 @@ static const struct blockinfo special_loaders[] =
 static bool load_dungeon_special(void);
 
 
+/* Savefile loading functions (static level saved in its own file) */
+static const struct blockinfo level_loaders[] =
+{
+    {"dungeons", rd_dungeon, 1},
+    {"objects", rd_objects, 1},
+    {"monsters", rd_monsters, 1},
+    {"traps", rd_traps, 1}
+};
+
+
 /* Savefile loading functions (account) */
 static const struct blockinfo account_loaders[] =
 {
@@ -242,8 +268,16 @@ static uint32_t buffer_pos;
 static uint32_t buffer_check;
 
 
+/*
+ * The save buffer is kept from one save to the next, and doubles in size
+ * whenever it fills up, so saving the server state doesn't realloc every
+ * kilobyte.
+ */
+static uint8_t *save_buffer;
+static uint32_t save_buffer_size;
+
+
 #define BUFFER_INITIAL_SIZE     1024
-#define BUFFER_BLOCK_INCREMENT  1024
 #define SAVEFILE_HEAD_SIZE      28
 
 
@@ -252,23 +286,49 @@ static uint32_t buffer_check;
  */
 
 
-static void sf_put(uint8_t v)
+/*
+ * Make room for "len" more bytes in the save buffer
+ */
+static void sf_reserve(uint32_t len)
 {
     my_assert(buffer != NULL);
     my_assert(buffer_size > 0);
 
-    if (buffer_size == buffer_pos)
-    {
-        buffer_size += BUFFER_BLOCK_INCREMENT;
-        buffer = mem_realloc(buffer, buffer_size);
-    }
+    if (buffer_pos + len <= buffer_size) return;
+
+    while (buffer_pos + len > buffer_size) buffer_size *= 2;
+    buffer = mem_realloc(buffer, buffer_size);
+}
+
+
+static void sf_put(uint8_t v)
+{
+    if (buffer_pos == buffer_size) sf_reserve(1);
 
-    my_assert(buffer_pos < buffer_size);
     buffer[buffer_pos++] = v;
     buffer_check += v;
 }
 
 
+/*
+ * Put a run of bytes in one go (same checksum as putting them one by one)
+ */
+static void sf_put_run(const uint8_t *data, uint32_t len)
+{
+    uint8_t *dest;
+    uint32_t i;
+
+    sf_reserve(len);
+    dest = buffer + buffer_pos;
+    for (i = 0; i < len; i++)
+    {
+        dest[i] = data[i];
+        buffer_check += data[i];
+    }
+    buffer_pos += len;
+}
+
+
 static uint8_t sf_get(void)
 {
     if ((buffer == NULL) || (buffer_size <= 0) || (buffer_pos >= buffer_size))
@@ -289,10 +349,19 @@ void wr_byte(uint8_t v)
 }
 
 
+void wr_bytes(const uint8_t *data, size_t len)
+{
+    sf_put_run(data, (uint32_t)len);
+}
+
+
 void wr_u16b(uint16_t v)
 {
-    sf_put((uint8_t)(v & 0xFF));
-    sf_put((uint8_t)((v >> 8) & 0xFF));
+    uint8_t bytes[2];
+
+    bytes[0] = (uint8_t)(v & 0xFF);
+    bytes[1] = (uint8_t)((v >> 8) & 0xFF);
+    sf_put_run(bytes, 2);
 }
 
 
@@ -304,10 +373,13 @@ void wr_s16b(int16_t v)
 
 void wr_u32b(uint32_t v)
 {
-    sf_put((uint8_t)(v & 0xFF));
-    sf_put((uint8_t)((v >> 8) & 0xFF));
-    sf_put((uint8_t)((v >> 16) & 0xFF));
-    sf_put((uint8_t)((v >> 24) & 0xFF));
+    uint8_t bytes[4];
+
+    bytes[0] = (uint8_t)(v & 0xFF);
+    bytes[1] = (uint8_t)((v >> 8) & 0xFF);
+    bytes[2] = (uint8_t)((v >> 16) & 0xFF);
+    bytes[3] = (uint8_t)((v >> 24) & 0xFF);
+    sf_put_run(bytes, 4);
 }
 
 
@@ -326,19 +398,18 @@ void wr_hturn(hturn* pv)
 
 void wr_loc(struct loc *l)
 {
-    wr_byte((uint8_t)l->y);
-    wr_byte((uint8_t)l->x);
+    uint8_t bytes[2];
+
+    bytes[0] = (uint8_t)l->y;
+    bytes[1] = (uint8_t)l->x;
+    sf_put_run(bytes, 2);
 }
 
 
 void wr_string(const char *str)
 {
-    while (*str)
-    {
-        wr_byte(*str);
-        str++;
-    }
-    wr_byte(*str);
+    /* Include the terminating null */
+    sf_put_run((const uint8_t *)str, (uint32_t)strlen(str) + 1);
 }
 
 
@@ -349,6 +420,74 @@ void wr_quark(quark_t v)
 }
 
 
+/*
+ * What the last autosave wrote for a level, one buffer per part
+ */
+struct level_image
+{
+    uint8_t *data[LEVEL_PART_MAX];
+    uint32_t len[LEVEL_PART_MAX];
+};
+
+
+/* The save in progress may copy the parts of unmodified levels */
+static bool save_reuse;
+
+
+void level_image_free(struct chunk *c)
+{
+    int part;
+
+    if (!c->image) return;
+
+    for (part = 0; part < LEVEL_PART_MAX; part++) mem_free(c->image->data[part]);
+    mem_free(c->image);
+    c->image = NULL;
+}
+
+
+/*
+ * Write one part of a level.
+ *
+ * Autosaves keep what they wrote for the levels without players on them, and copy it back
+ * into the next autosave as long as nothing marks the level as modified. Levels with players
+ * on them are always written out, and so is everything in a normal or panic save.
+ */
+void wr_level_part(struct chunk *c, int part, void (*wr_part)(struct chunk *c))
+{
+    uint32_t start = buffer_pos;
+
+    if (!save_reuse)
+    {
+        wr_part(c);
+        return;
+    }
+
+    /* The level changed since it was last written */
+    if (c->modified || c->players)
+    {
+        level_image_free(c);
+        c->modified = false;
+    }
+
+    /* Nothing happened there: reuse what was written last time */
+    if (c->image && c->image->data[part])
+    {
+        sf_put_run(c->image->data[part], c->image->len[part]);
+        return;
+    }
+
+    wr_part(c);
+
+    /* Keep a copy for the next autosave */
+    if (c->players) return;
+    if (!c->image) c->image = mem_zalloc(sizeof(struct level_image));
+    c->image->len[part] = buffer_pos - start;
+    c->image->data[part] = mem_alloc(c->image->len[part]);
+    memcpy(c->image->data[part], buffer + start, c->image->len[part]);
+}
+
+
 /** Reading bits **/
 
 
@@ -469,14 +608,86 @@ void strip_string(int max)
  */
 
 
-static bool try_save(void *data, ang_file *file, savefile_saver *savers, size_t n_savers)
+/*
+ * A savefile built in memory. Building it is quick, and is done on the game
+ * thread; writing it to disk is slow, and is done on the writer thread when
+ * there is one (autosaves).
+ */
+struct save_image
+{
+    struct save_image *next;
+    char *data;
+    size_t len;
+    size_t size;
+    char path[MSG_LEN];         /* Savefile */
+    char new_path[MSG_LEN];     /* Written first, then renamed to "path" */
+    char old_path[MSG_LEN];     /* Previous savefile while it is replaced */
+    bool level;                 /* Savefile of a static level... */
+    struct worldpos wpos;       /* ...at this position... */
+    uint32_t save_id;           /* ...for this chunk */
+    bool remove;                /* Delete the savefile instead of writing it */
+    bool waited;                /* The game thread waits for this one */
+    bool done;                  /* Written (or failed) */
+    bool ok;                    /* The savefile made it to disk */
+};
+
+
+/* Autosaves not checked yet */
+static struct save_image *save_results;
+static int save_pending;
+
+/* Level savefiles queued for deletion */
+static int save_removing;
+
+
+#ifdef USE_PTHREADS
+static pthread_t save_thread;
+static pthread_mutex_t save_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t save_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t save_done = PTHREAD_COND_INITIALIZER;
+static struct save_image *save_queue;
+static struct save_image *save_queue_tail;
+static bool save_running;
+static bool save_stop;
+static bool save_broken;
+#endif
+
+
+static void image_append(struct save_image *img, const void *data, size_t len)
+{
+    if (img->len + len > img->size)
+    {
+        if (!img->size) img->size = BUFFER_INITIAL_SIZE;
+        while (img->len + len > img->size) img->size *= 2;
+        img->data = mem_realloc(img->data, img->size);
+    }
+
+    memcpy(img->data + img->len, data, len);
+    img->len += len;
+}
+
+
+static void image_free(struct save_image *img)
+{
+    mem_free(img->data);
+    mem_free(img);
+}
+
+
+static bool try_save(void *data, struct save_image *img, const savefile_saver *savers,
+    size_t n_savers)
 {
     uint8_t savefile_head[SAVEFILE_HEAD_SIZE];
     size_t i, pos;
 
-    /* Start off the buffer */
-    buffer = mem_alloc(BUFFER_INITIAL_SIZE);
-    buffer_size = BUFFER_INITIAL_SIZE;
+    /* Start off the buffer (or pick up the one from the last save) */
+    if (!save_buffer)
+    {
+        save_buffer = mem_alloc(BUFFER_INITIAL_SIZE);
+        save_buffer_size = BUFFER_INITIAL_SIZE;
+    }
+    buffer = save_buffer;
+    buffer_size = save_buffer_size;
 
     for (i = 0; i < n_savers; i++)
     {
@@ -501,18 +712,39 @@ static bool try_save(void *data, ang_file *file, savefile_saver *savers, size_t
 
         my_assert(pos == SAVEFILE_HEAD_SIZE);
 
-        file_write(file, (char *)savefile_head, SAVEFILE_HEAD_SIZE);
-        file_write(file, (char *)buffer, buffer_pos);
+        image_append(img, savefile_head, SAVEFILE_HEAD_SIZE);
+        image_append(img, buffer, buffer_pos);
 
         /* Pad to 4 byte multiples */
-        if (buffer_pos % 4) file_write(file, "xxx", 4 - (buffer_pos % 4));
+        if (buffer_pos % 4) image_append(img, "xxx", 4 - (buffer_pos % 4));
     }
 
-    mem_free(buffer);
+    /* Keep the buffer for the next save */
+    save_buffer = buffer;
+    save_buffer_size = buffer_size;
+    buffer = NULL;
+
     return true;
 }
 
 
+/*
+ * Build a savefile in memory
+ */
+static struct save_image *image_make(const char *path, void *data, const savefile_saver *savers,
+    size_t n_savers)
+{
+    struct save_image *img = mem_zalloc(sizeof(*img));
+
+    my_strcpy(img->path, path, sizeof(img->path));
+    image_append(img, savefile_magic, 4);
+    image_append(img, savefile_name, 4);
+    try_save(data, img, savers, n_savers);
+
+    return img;
+}
+
+
 /*
  * Set filename to a new filename based on an existing filename, using
  * the specified file extension. Make it shorter than the specified
@@ -529,73 +761,230 @@ static void file_get_savefile(char *filename, size_t max, const char *base, cons
 
 
 /*
- * Attempt to save the player in a savefile
+ * Write a savefile to a new file, and put it in place of the previous one once
+ * it is safely on disk. This may run on the writer thread.
  */
-bool save_player(struct player *p, bool panic)
+static bool image_write(struct save_image *img)
 {
     ang_file *file;
-    char new_savefile[MSG_LEN];
-    char old_savefile[MSG_LEN];
-    bool character_saved = false;
+    bool err = false;
 
-    /* Panic save is quick */
-    if (panic)
+    /* The savefile goes away, after whatever was queued before */
+    if (img->remove)
     {
-        file = file_open(p->panicfile, MODE_WRITE, FTYPE_SAVE);
-        if (file)
-        {
-            file_write(file, (char *)&savefile_magic, 4);
-            file_write(file, (char *)&savefile_name, 4);
+        if (file_exists(img->path)) return file_delete(img->path);
+        return true;
+    }
 
-            character_saved = try_save((void *)p, file, (savefile_saver *)player_savers,
-                N_ELEMENTS(player_savers));
-            file_close(file);
-        }
-        if (character_saved) return true;
-        if (file) file_delete(p->panicfile);
+    file = file_open(img->new_path, MODE_WRITE, FTYPE_SAVE);
+    if (!file) return false;
+    if (!file_write(file, img->data, img->len) || !file_sync(file)) err = true;
+    file_close(file);
+
+    /* Delete temp file if the save failed */
+    if (err)
+    {
+        file_delete(img->new_path);
         return false;
     }
 
-    /* New savefile */
-    file_get_savefile(old_savefile, sizeof(old_savefile), p->savefile, "old");
-
-    /* Open the savefile */
-    file_get_savefile(new_savefile, sizeof(new_savefile), p->savefile, "new");
-    file = file_open(new_savefile, MODE_WRITE, FTYPE_SAVE);
+    if (file_exists(img->path) && !file_move(img->path, img->old_path))
+        err = true;
 
-    if (file)
+    if (!err)
     {
-        file_write(file, (char *)&savefile_magic, 4);
-        file_write(file, (char *)&savefile_name, 4);
+        if (!file_move(img->new_path, img->path)) err = true;
 
-        character_saved = try_save((void *)p, file, (savefile_saver *)player_savers,
-            N_ELEMENTS(player_savers));
-        file_close(file);
+        if (err) file_move(img->old_path, img->path);
+        else file_delete(img->old_path);
     }
 
-    /* Attempt to save the player */
-    if (character_saved)
+    return !err;
+}
+
+
+/*
+ * Panic save is quick: write straight to the panic savefile
+ */
+static bool image_write_panic(struct save_image *img, const char *path)
+{
+    ang_file *file = file_open(path, MODE_WRITE, FTYPE_SAVE);
+    bool saved;
+
+    if (!file) return false;
+    saved = file_write(file, img->data, img->len);
+    file_close(file);
+    if (!saved) file_delete(path);
+
+    return saved;
+}
+
+
+#ifdef USE_PTHREADS
+/*
+ * The writer thread: write the queued savefiles in order
+ */
+static void *save_thread_main(void *arg)
+{
+    pthread_mutex_lock(&save_lock);
+    while (true)
     {
-        bool err = false;
+        struct save_image *img;
 
-        if (file_exists(p->savefile) && !file_move(p->savefile, old_savefile))
-            err = true;
+        while (!save_queue && !save_stop) pthread_cond_wait(&save_work, &save_lock);
+        if (!save_queue) break;
 
-        if (!err)
-        {
-            if (!file_move(new_savefile, p->savefile)) err = true;
+        img = save_queue;
+        save_queue = img->next;
+        if (!save_queue) save_queue_tail = NULL;
+        pthread_mutex_unlock(&save_lock);
+
+        img->ok = image_write(img);
 
-            if (err) file_move(old_savefile, p->savefile);
-            else file_delete(old_savefile);
+        pthread_mutex_lock(&save_lock);
+        img->done = true;
+        if (img->waited) pthread_cond_broadcast(&save_done);
+        else
+        {
+            img->next = save_results;
+            save_results = img;
         }
+    }
+    pthread_mutex_unlock(&save_lock);
+
+    return NULL;
+}
+
+
+static bool save_thread_start(void)
+{
+    sigset_t all, old;
+    int err;
+
+    if (save_broken) return false;
+
+    /* Signals are for the game thread */
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    save_stop = false;
+    err = pthread_create(&save_thread, NULL, save_thread_main, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
 
-        return !err;
+    if (err)
+    {
+        plog_fmt("Cannot start the savefile writer thread, error %d", err);
+        save_broken = true;
+        return false;
     }
 
-    /* Delete temp file if the save failed */
-    if (file) file_delete(new_savefile);
+    save_running = true;
+    return true;
+}
 
-    return false;
+
+static void save_thread_push(struct save_image *img)
+{
+    pthread_mutex_lock(&save_lock);
+    img->next = NULL;
+    if (save_queue_tail) save_queue_tail->next = img;
+    else save_queue = img;
+    save_queue_tail = img;
+    pthread_cond_signal(&save_work);
+    pthread_mutex_unlock(&save_lock);
+}
+#endif
+
+
+/*
+ * Write a savefile now. If the writer thread is running, it writes the
+ * savefile after the pending autosaves, so an older snapshot can't overwrite
+ * this one.
+ */
+static bool image_commit(struct save_image *img)
+{
+    bool saved;
+
+    file_get_savefile(img->old_path, sizeof(img->old_path), img->path, "old");
+    file_get_savefile(img->new_path, sizeof(img->new_path), img->path, "new");
+
+#ifdef USE_PTHREADS
+    if (save_running)
+    {
+        img->waited = true;
+        save_thread_push(img);
+        pthread_mutex_lock(&save_lock);
+        while (!img->done) pthread_cond_wait(&save_done, &save_lock);
+        pthread_mutex_unlock(&save_lock);
+        saved = img->ok;
+        image_free(img);
+        return saved;
+    }
+#endif
+
+    saved = image_write(img);
+    image_free(img);
+
+    return saved;
+}
+
+
+/*
+ * Write a savefile in the background. The result shows up in autosave_check().
+ */
+static void image_autosave(struct save_image *img)
+{
+    file_get_savefile(img->old_path, sizeof(img->old_path), img->path, "old");
+    file_get_savefile(img->new_path, sizeof(img->new_path), img->path, "new");
+    save_pending++;
+
+#ifdef USE_PTHREADS
+    if (save_running || save_thread_start())
+    {
+        save_thread_push(img);
+        return;
+    }
+#endif
+
+    /* No writer thread: write it now */
+    img->ok = image_write(img);
+    img->done = true;
+    img->next = save_results;
+    save_results = img;
+}
+
+
+/*
+ * Attempt to save the player in a savefile
+ */
+bool save_player(struct player *p, bool panic)
+{
+    struct save_image *img = image_make(p->savefile, (void *)p, player_savers,
+        N_ELEMENTS(player_savers));
+
+    if (panic)
+    {
+        bool saved = image_write_panic(img, p->panicfile);
+
+        image_free(img);
+        return saved;
+    }
+
+    if (!image_commit(img)) return false;
+    p->upkeep->dirty = false;
+    return true;
+}
+
+
+/*
+ * Save the player in the background
+ */
+void autosave_player(struct player *p)
+{
+    /* Nothing worth saving happened since the last save */
+    if (!p->upkeep->dirty) return;
+    p->upkeep->dirty = false;
+
+    image_autosave(image_make(p->savefile, (void *)p, player_savers, N_ELEMENTS(player_savers)));
 }
 
 
@@ -625,88 +1014,201 @@ void save_dungeon_special(struct worldpos *wpos, bool town)
     file = file_open(filename, MODE_WRITE, FTYPE_RAW);
     if (file)
     {
+        struct save_image img;
+
         /* Save the level */
         plog_fmt("Saving special file: %s", lvlname);
-        try_save((void *)wpos, file, (savefile_saver *)special_savers, N_ELEMENTS(special_savers));
+        memset(&img, 0, sizeof(img));
+        try_save((void *)wpos, &img, special_savers, N_ELEMENTS(special_savers));
+        file_write(file, img.data, img.len);
         file_close(file);
+        mem_free(img.data);
     }
 }
 
 
 /*
- * Save the server state to a "server" savefile.
+ * Static levels that aren't special levels, towns or house levels are saved in separate
+ * files with the filename "server.chunk.<wild_x>.<wild_y>.<depth>".
  */
-bool save_server_info(bool panic)
+static void level_get_savefile(char *filename, size_t max, const char *dir,
+    struct worldpos *wpos)
 {
-    ang_file *file;
-    char new_savefile[MSG_LEN];
-    char old_savefile[MSG_LEN];
-    char filename[MSG_LEN];
-    bool server_saved = false;
+    char lvlname[32];
+
+    strnfmt(lvlname, sizeof(lvlname), "server.chunk.%d.%d.%d", wpos->grid.x, wpos->grid.y,
+        wpos->depth);
+    path_build(filename, max, dir, lvlname);
+}
+
+
+/*
+ * Build the savefile of a static level saved in its own file
+ */
+static struct save_image *level_image_make(struct chunk *c)
+{
+    static uint32_t save_id;
+    char savefile[MSG_LEN];
+    struct save_image *img;
+
+    level_get_savefile(savefile, sizeof(savefile), ANGBAND_DIR_SAVE, &c->wpos);
+    img = image_make(savefile, (void *)c, level_savers, N_ELEMENTS(level_savers));
+    img->level = true;
+    memcpy(&img->wpos, &c->wpos, sizeof(struct worldpos));
+    if (!c->save_id) c->save_id = ++save_id;
+    img->save_id = c->save_id;
+
+    /* The savefile is up to date */
+    c->modified = false;
+
+    return img;
+}
+
+
+/*
+ * Check if a static level saved in its own file changed since it was last saved
+ */
+static bool level_needs_save(struct chunk *c)
+{
+    char savefile[MSG_LEN];
+
+    if (!c || !level_keep_allocated(c) || !level_saved_apart(&c->wpos)) return false;
+    if (c->modified) return true;
+
+    /* The savefile may still be there, about to be deleted */
+    if (save_removing) return true;
+
+    level_get_savefile(savefile, sizeof(savefile), ANGBAND_DIR_SAVE, &c->wpos);
+    return !file_exists(savefile);
+}
+
+
+/*
+ * Save a static level in its own file
+ */
+static bool save_level(struct chunk *c, bool panic)
+{
+    struct save_image *img = level_image_make(c);
 
-    /* Panic save is quick */
     if (panic)
     {
-        path_build(new_savefile, sizeof(new_savefile), ANGBAND_DIR_PANIC, "server");
-        file = file_open(new_savefile, MODE_WRITE, FTYPE_SAVE);
-        if (file)
-        {
-            file_write(file, (char *)&savefile_magic, 4);
-            file_write(file, (char *)&savefile_name, 4);
+        char savefile[MSG_LEN];
+        bool saved;
 
-            server_saved = try_save(NULL, file, (savefile_saver *)server_savers,
-                N_ELEMENTS(server_savers));
-            file_close(file);
-        }
-        if (server_saved) return true;
-        if (file) file_delete(new_savefile);
-        return false;
+        level_get_savefile(savefile, sizeof(savefile), ANGBAND_DIR_PANIC, &c->wpos);
+        saved = image_write_panic(img, savefile);
+        image_free(img);
+        return saved;
     }
 
-    /* New savefile */
-    path_build(filename, sizeof(filename), ANGBAND_DIR_SAVE, "server");
-    file_get_savefile(old_savefile, sizeof(old_savefile), filename, "old");
+    if (image_commit(img)) return true;
 
-    /* Open the savefile */
-    file_get_savefile(new_savefile, sizeof(new_savefile), filename, "new");
-    file = file_open(new_savefile, MODE_WRITE, FTYPE_SAVE);
+    /* Try again next time */
+    c->modified = true;
+    return false;
+}
 
-    if (file)
-    {
-        file_write(file, (char *)&savefile_magic, 4);
-        file_write(file, (char *)&savefile_name, 4);
 
-        server_saved = try_save(NULL, file, (savefile_saver *)server_savers,
-            N_ELEMENTS(server_savers));
-        file_close(file);
+/*
+ * Save a static level in its own file in the background, if it changed. Returns
+ * true once the file is up to date.
+ */
+bool autosave_level(struct chunk *c)
+{
+    if (level_needs_save(c))
+    {
+        c->saving++;
+        image_autosave(level_image_make(c));
     }
 
-    /* Attempt to save the server state */
-    if (server_saved)
+    return (!c->saving && !c->modified);
+}
+
+
+/*
+ * Delete the savefile of a static level that is gone
+ *
+ * If autosaves are still pending, one of them may be that level: the deletion is queued
+ * behind them, so the savefile can't show up again once it is deleted.
+ */
+void delete_level(struct worldpos *wpos)
+{
+    char savefile[MSG_LEN];
+
+    level_get_savefile(savefile, sizeof(savefile), ANGBAND_DIR_SAVE, wpos);
+    if (save_pending)
     {
-        char savefile[MSG_LEN];
-        bool err = false;
+        struct save_image *img = mem_zalloc(sizeof(*img));
 
-        path_build(savefile, sizeof(savefile), ANGBAND_DIR_SAVE, "server");
+        my_strcpy(img->path, savefile, sizeof(img->path));
+        img->remove = true;
+        save_removing++;
+        image_autosave(img);
+    }
+    else if (file_exists(savefile)) file_delete(savefile);
+    level_get_savefile(savefile, sizeof(savefile), ANGBAND_DIR_PANIC, wpos);
+    if (file_exists(savefile)) file_delete(savefile);
 
-        if (file_exists(savefile) && !file_move(savefile, old_savefile))
-            err = true;
+    chunk_set_on_disk(wpos, false);
+}
 
-        if (!err)
-        {
-            if (!file_move(new_savefile, savefile)) err = true;
 
-            if (err) file_move(old_savefile, savefile);
-            else file_delete(old_savefile);
-        }
+/*
+ * Save the server state to a "server" savefile.
+ */
+bool save_server_info(bool panic)
+{
+    char savefile[MSG_LEN];
+    struct save_image *img;
+    bool saved;
+    int i;
 
-        return !err;
+    path_build(savefile, sizeof(savefile), ANGBAND_DIR_SAVE, "server");
+    img = image_make(savefile, NULL, server_savers, N_ELEMENTS(server_savers));
+
+    if (panic)
+    {
+        path_build(savefile, sizeof(savefile), ANGBAND_DIR_PANIC, "server");
+        saved = image_write_panic(img, savefile);
+        image_free(img);
     }
+    else
+        saved = image_commit(img);
 
-    /* Delete temp file if the save failed */
-    if (file) file_delete(new_savefile);
+    /* Save the static levels saved in their own file */
+    for (i = 0; i < chunk_list_max(); i++)
+    {
+        struct chunk *c = chunk_list_at(i);
 
-    return false;
+        if (level_needs_save(c) && !save_level(c, panic)) saved = false;
+    }
+
+    return saved;
+}
+
+
+/*
+ * Save the server state in the background
+ */
+void autosave_server_info(void)
+{
+    char savefile[MSG_LEN];
+    struct save_image *img;
+    int i;
+
+    path_build(savefile, sizeof(savefile), ANGBAND_DIR_SAVE, "server");
+    save_reuse = true;
+    img = image_make(savefile, NULL, server_savers, N_ELEMENTS(server_savers));
+    save_reuse = false;
+    image_autosave(img);
+
+    /* Save the static levels saved in their own file that changed */
+    for (i = 0; i < chunk_list_max(); i++)
+    {
+        struct chunk *c = chunk_list_at(i);
+
+        if (c) autosave_level(c);
+    }
 }
 
 
@@ -715,75 +1217,115 @@ bool save_server_info(bool panic)
  */
 bool save_account_info(bool panic)
 {
-    ang_file *file;
-    char new_savefile[MSG_LEN];
-    char old_savefile[MSG_LEN];
-    char filename[MSG_LEN];
-    bool account_saved = false;
+    char savefile[MSG_LEN];
+    struct save_image *img;
+
+    path_build(savefile, sizeof(savefile), ANGBAND_DIR_SAVE, "players");
+    img = image_make(savefile, NULL, account_savers, N_ELEMENTS(account_savers));
 
-    /* Panic save is quick */
     if (panic)
     {
-        path_build(new_savefile, sizeof(new_savefile), ANGBAND_DIR_PANIC, "players");
-        file = file_open(new_savefile, MODE_WRITE, FTYPE_SAVE);
-        if (file)
-        {
-            file_write(file, (char *)&savefile_magic, 4);
-            file_write(file, (char *)&savefile_name, 4);
+        bool saved;
 
-            account_saved = try_save(NULL, file, (savefile_saver *)account_savers,
-                N_ELEMENTS(account_savers));
-            file_close(file);
-        }
-        if (account_saved) return true;
-        if (file) file_delete(new_savefile);
-        return false;
+        path_build(savefile, sizeof(savefile), ANGBAND_DIR_PANIC, "players");
+        saved = image_write_panic(img, savefile);
+        image_free(img);
+        return saved;
     }
 
-    /* New savefile */
-    path_build(filename, sizeof(filename), ANGBAND_DIR_SAVE, "players");
-    file_get_savefile(old_savefile, sizeof(old_savefile), filename, "old");
+    return image_commit(img);
+}
 
-    /* Open the savefile */
-    file_get_savefile(new_savefile, sizeof(new_savefile), filename, "new");
-    file = file_open(new_savefile, MODE_WRITE, FTYPE_SAVE);
 
-    if (file)
-    {
-        file_write(file, (char *)&savefile_magic, 4);
-        file_write(file, (char *)&savefile_name, 4);
+/*
+ * Save the player names in the background
+ */
+void autosave_account_info(void)
+{
+    char savefile[MSG_LEN];
 
-        account_saved = try_save(NULL, file, (savefile_saver *)account_savers,
-            N_ELEMENTS(account_savers));
-        file_close(file);
-    }
+    path_build(savefile, sizeof(savefile), ANGBAND_DIR_SAVE, "players");
+    image_autosave(image_make(savefile, NULL, account_savers, N_ELEMENTS(account_savers)));
+}
+
+
+/*
+ * Report the background saves that are done, and whether they made it to disk
+ */
+void autosave_check(void)
+{
+    struct save_image *img;
+
+    if (!save_pending) return;
+
+#ifdef USE_PTHREADS
+    if (save_running) pthread_mutex_lock(&save_lock);
+#endif
+    img = save_results;
+    save_results = NULL;
+#ifdef USE_PTHREADS
+    if (save_running) pthread_mutex_unlock(&save_lock);
+#endif
 
-    /* Attempt to save the player names */
-    if (account_saved)
+    while (img)
     {
-        char savefile[MSG_LEN];
-        bool err = false;
+        struct save_image *next = img->next;
+        struct chunk *c = (img->level? chunk_get(&img->wpos): NULL);
+
+        /* Not the same level if it was generated again since */
+        if (c && (c->save_id != img->save_id)) c = NULL;
 
-        path_build(savefile, sizeof(savefile), ANGBAND_DIR_SAVE, "players");
+        /* The level can be swapped out once its saves are done */
+        if (c && c->saving) c->saving--;
 
-        if (file_exists(savefile) && !file_move(savefile, old_savefile))
-            err = true;
+        if (img->remove) save_removing--;
 
-        if (!err)
+        if (!img->ok)
         {
-            if (!file_move(new_savefile, savefile)) err = true;
+            int i;
+
+            plog_fmt("Autosave failed: %s", img->path);
 
-            if (err) file_move(old_savefile, savefile);
-            else file_delete(old_savefile);
+            /* Try again next time if this was a level still around */
+            if (c) c->modified = true;
+
+            /* Try again next time if this was a player still around */
+            for (i = 1; i <= NumPlayers; i++)
+            {
+                struct player *p = player_get(i);
+
+                if (streq(p->savefile, img->path)) p->upkeep->dirty = true;
+            }
         }
+        save_pending--;
+        image_free(img);
+        img = next;
+    }
+}
 
-        return !err;
+
+/*
+ * Wait for the background saves to land, and stop the writer thread
+ */
+void autosave_stop(void)
+{
+#ifdef USE_PTHREADS
+    if (save_running)
+    {
+        pthread_mutex_lock(&save_lock);
+        save_stop = true;
+        pthread_cond_signal(&save_work);
+        pthread_mutex_unlock(&save_lock);
+        pthread_join(save_thread, NULL);
+        save_running = false;
     }
+#endif
 
-    /* Delete temp file if the save failed */
-    if (file) file_delete(new_savefile);
+    autosave_check();
 
-    return false;
+    mem_free(save_buffer);
+    save_buffer = NULL;
+    save_buffer_size = 0;
 }
 
 
@@ -939,7 +1481,7 @@ static bool try_load(struct player *p, ang_file *f, const struct blockinfo *load
         }
 
         /* Load any special static levels */
-        if (streq(b.name, "dungeons"))
+        if ((loaders == server_loaders) && streq(b.name, "dungeons"))
         {
             if (!load_dungeon_special()) return false;
         }
@@ -1400,6 +1942,78 @@ bool load_server_info(void)
 }
 
 
+/*
+ * Load a static level swapped out to its own savefile, when a player enters it.
+ *
+ * Returns the level, or NULL if the level is not on disk.
+ */
+struct chunk *load_level(struct worldpos *wpos)
+{
+    bool ok;
+    ang_file *f;
+    char savefile[MSG_LEN];
+    char panicfile[MSG_LEN];
+    const char *loadpath;
+    int16_t count = chunk_get_player_count(wpos);
+    struct chunk *c;
+
+    if (!chunk_on_disk(wpos)) return NULL;
+    chunk_set_on_disk(wpos, false);
+
+    level_get_savefile(savefile, sizeof(savefile), ANGBAND_DIR_SAVE, wpos);
+    level_get_savefile(panicfile, sizeof(panicfile), ANGBAND_DIR_PANIC, wpos);
+    loadpath = savefile_get_name(savefile, panicfile);
+
+    /* Open savefile */
+    f = (loadpath? file_open(loadpath, MODE_READ, FTYPE_RAW): NULL);
+    if (!f)
+    {
+        plog_fmt("Couldn't open level savefile %s.", savefile);
+        return NULL;
+    }
+
+    ok = try_load(NULL, f, level_loaders, N_ELEMENTS(level_loaders), true);
+    file_close(f);
+
+    c = chunk_get(wpos);
+    if (!ok)
+    {
+        /* Get rid of what was read so far, a new level will be generated */
+        if (c)
+        {
+            chunk_list_remove(c);
+            cave_wipe(c);
+        }
+        return NULL;
+    }
+
+    /* Players may have come and gone since the level was saved */
+    chunk_set_player_count(wpos, count);
+    c->modified = false;
+
+    return c;
+}
+
+
+/*
+ * Get rid of a static level swapped out to disk once it is unstaticed
+ *
+ * The level is read back first, so that its uniques and artifacts are released.
+ */
+void forget_level(struct worldpos *wpos)
+{
+    struct chunk *c = load_level(wpos);
+
+    if (c)
+    {
+        chunk_list_remove(c);
+        cave_wipe(c);
+    }
+    else
+        delete_level(wpos);
+}
+
+
 /*
  * Load the player names from a special savefile.
  */
@@ -18,8 +18,19 @@
 #define ITEM_VERSION 1
 #define EGO_ART_KNOWN 0xFFFF
 
+/* Parts of a level written to the server savefile, one per block */
+enum
+{
+    LEVEL_PART_DUNGEON = 0,
+    LEVEL_PART_OBJECTS,
+    LEVEL_PART_MONSTERS,
+    LEVEL_PART_TRAPS,
+    LEVEL_PART_MAX
+};
+
 /* Writing bits */
 extern void wr_byte(uint8_t v);
+extern void wr_bytes(const uint8_t *data, size_t len);
 extern void wr_u16b(uint16_t v);
 extern void wr_s16b(int16_t v);
 extern void wr_u32b(uint32_t v);
@@ -28,6 +39,8 @@ extern void wr_hturn(hturn* pv);
 extern void wr_loc(struct loc *l);
 extern void wr_string(const char *str);
 extern void wr_quark(quark_t v);
+extern void wr_level_part(struct chunk *c, int part, void (*wr_part)(struct chunk *c));
+extern void level_image_free(struct chunk *c);
 
 /* Reading bits */
 extern void rd_byte(uint8_t *ip);
@@ -64,6 +77,7 @@ extern int rd_objects(struct player *unused);
 extern int rd_monsters(struct player *unused);
 extern int rd_player_traps(struct player *p);
 extern int rd_traps(struct player *unused);
+extern int rd_levels(struct player *unused);
 extern int rd_history(struct player *p);
 extern int rd_null(struct player *unused);
 extern int rd_header(struct player *p);
@@ -91,12 +105,13 @@ extern void wr_gear(void *data);
 extern void wr_stores(void *unused);
 extern void wr_player_dungeon(void *data);
 extern void wr_level(void *data);
-extern void wr_dungeon(void *unused);
+extern void wr_dungeon(void *data);
 extern void wr_player_objects(void *data);
-extern void wr_objects(void *unused);
-extern void wr_monsters(void *unused);
+extern void wr_objects(void *data);
+extern void wr_monsters(void *data);
 extern void wr_player_traps(void *data);
-extern void wr_traps(void *unused);
+extern void wr_traps(void *data);
+extern void wr_levels(void *unused);
 extern void wr_history(void *data);
 extern void wr_header(void *data);
 extern void wr_wild_map(void *data);
@@ -113,12 +128,21 @@ extern void wr_player_names(void *unused);
 extern const char *savefile_get_description(const char *path);
 
 extern bool save_player(struct player *p, bool panic);
+extern void autosave_player(struct player *p);
 extern void save_dungeon_special(struct worldpos *wpos, bool town);
+extern bool autosave_level(struct chunk *c);
+extern void delete_level(struct worldpos *wpos);
 extern bool save_server_info(bool panic);
+extern void autosave_server_info(void);
 extern bool save_account_info(bool panic);
+extern void autosave_account_info(void);
+extern void autosave_check(void);
+extern void autosave_stop(void);
 extern bool load_player(struct player *p, const char *loadpath);
 extern int scoop_player(char *nick, char *pass, uint8_t *pridx, uint8_t *pcidx, uint8_t *psex);
 extern bool load_server_info(void);
+extern struct chunk *load_level(struct worldpos *wpos);
+extern void forget_level(struct worldpos *wpos);
 extern bool load_account_info(void);
 extern bool special_level(struct worldpos *wpos);
 extern bool special_town(struct worldpos *wpos);
@@ -19,11 +19,15 @@
 
 #define SERVER
 
-#define _POSIX_SOURCE
+#define _POSIX_C_SOURCE 200112L
 
 #include "s-angband.h"
-#include <signal.h>
 #include <sys/time.h>
+#include <time.h>
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#endif
 
 #ifndef TRUE
 #define TRUE true
@@ -36,171 +40,10 @@ void core(const char* msg)
 {
     exit(-1);
 }
-void remove_timer_tick(void)
-{
-    /* .. */
-}
 
 /*char sched_version[] = VERSION;*/
 
-#ifdef sony_news
-/*
- * Sony NEWS doesn't have the sigset family.
- */
-typedef unsigned int    sigset_t;
-
-#define sigemptyset(set)        (*(set) = 0)
-#define sigfillset(set)         (*(set) = ~(sigset_t)0, 0)
-#define sigaddset(set,signo)    (*(set) |= sigmask(signo), 0)
-#define sigdelset(set,signo)    (*(set) &= ~sigmask(signo), 0)
-#define sigismember(set,signo)  ((*(set) & sigmask(signo)) != 0)
-
-#define SIG_BLOCK		1
-#define SIG_UNBLOCK		2
-#define SIG_SETMASK		3
-
-int sigprocmask(int how, const sigset_t *set, sigset_t *oset)
-{
-    int			mask;
-
-    if (how == SIG_BLOCK) {
-	mask = sigblock(0) | *set;
-    }
-    else if (how == SIG_UNBLOCK) {
-	mask = sigblock(0) & ~(*set);
-    }
-    else if (how == SIG_SETMASK) {
-	mask = *set;
-    }
-    else {
-	mask = sigblock(0);
-    }
-    mask = sigsetmask(mask);
-    if (oset != NULL) {
-	*oset = mask;
-    }
-
-    return 0;
-}
-
-/*
- * Sony NEWS doesn't have sigaction(), using sigvec() instead.
- */
-#define sigaction	sigvec
-#define sa_handler	sv_handler
-#define sa_mask		sv_mask
-#define sa_flags	sv_flags
-#endif
-
-
-/*
- * Block or unblock a single signal.
- */
-static void sig_ok(int signum, int flag)
-{
-    sigset_t    sigset;
-
-    sigemptyset(&sigset);
-    sigaddset(&sigset, signum);
-    if (sigprocmask((flag) ? SIG_UNBLOCK : SIG_BLOCK, &sigset, NULL) == -1) {
-	plog(format("sigprocmask(%d,%d)", signum, flag));
-	exit(1);
-    }
-}
-
-/*
- * Prevent the real-time timer from interrupting system calls.
- * Globally accessible.
- */
-void block_timer(void)
-{
-    sig_ok(SIGALRM, 0);
-}
-
-/*
- * Unblock the real-time timer.
- * Globally accessible.
- */
-void allow_timer(void)
-{
-    sig_ok(SIGALRM, 1);
-}
-
-static volatile long	timer_ticks;	/* SIGALRMs that have occurred */
-static long		timers_used;	/* SIGALRMs that have been used */
-static long		timer_freq;	/* rate at which timer ticks. */
-static void		(*timer_handler)(void);
-static time_t		current_time;
-static int		ticks_till_second;
-
-/*
- * Catch SIGALRM.
- */
-static void catch_timer(int signum)
-{
-    timer_ticks++;
-}
-
-/*
- * Setup the handling of the SIGALRM signal
- * and setup the real-time interval timer.
- */
-static void setup_timer(void)
-{
-    struct itimerval itv;
-    struct sigaction act;
-
-    /*
-     * Prevent SIGALRMs from disturbing the initialization.
-     */
-    block_timer();
-
-    /*
-     * Install a signal handler for the alarm signal.
-     */
-    act.sa_handler = catch_timer;
-    act.sa_flags = 0;
-    sigemptyset(&act.sa_mask);
-    sigaddset(&act.sa_mask, SIGALRM);
-    if (sigaction(SIGALRM, &act, (struct sigaction *)NULL) == -1) {
-	plog("sigaction SIGALRM");
-	exit(1);
-    }
-
-    /*
-     * Install a real-time timer.
-     */
-    if (timer_freq <= 0) {
-	plog(format("illegal timer frequency: %ld", timer_freq));
-	exit(1);
-    }
-    itv.it_interval.tv_sec = 0;
-    itv.it_interval.tv_usec = 1000000 / timer_freq;
-    itv.it_value = itv.it_interval;
-    if (setitimer(ITIMER_REAL, &itv, NULL) == -1) {
-	plog("setitimer failed");
-	exit(1);
-    }
-
-    timers_used = timer_ticks;
-    time(&current_time);
-    ticks_till_second = timer_freq;
-
-    /*
-     * Allow the real-time timer to generate SIGALRM signals.
-     */
-    allow_timer();
-}
-
-/*
- * Configure timer tick callback.
- */
-void install_timer_tick(void (*func)(void), int freq)
-{
-    timer_handler = func;
-    timer_freq = freq;
-    setup_timer();
-}
+static time_t		current_time;	/* advanced once per second by the frame pacer */
 
 struct to_handler {
     struct to_handler	*next;
@@ -319,13 +162,194 @@ static void timeout_chime(void)
     }
 }
 
-#define NUM_SELECT_FD		(sizeof(int) * 8)
-
 struct io_handler {
     void		(*func)(int, int);
     int			arg;
+    void		(*out_func)(int, int);	/* called when writable */
+    int			out_arg;
 };
 
+#ifdef USE_EPOLL
+
+/*
+ * epoll(7) backend: the kernel keeps the interest set, so a wakeup only
+ * reports the descriptors that are actually readable and dispatch cost
+ * scales with the number of active sockets rather than with the highest fd.
+ * Descriptors are registered level-triggered, which matches what the select()
+ * backend does: a handler that doesn't drain its socket is simply called again.
+ */
+#define MAX_EPOLL_EVENTS	64
+
+static struct io_handler *input_handlers = NULL;
+static int              biggest_fd = -1;
+static int		epoll_fd = -1;
+static struct epoll_event epoll_events[MAX_EPOLL_EVENTS];
+
+static void grow_handlers(int fd)
+{
+    if (epoll_fd == -1) {
+	epoll_fd = epoll_create(MAX_EPOLL_EVENTS);
+	if (epoll_fd == -1) {
+	    plog(format("epoll_create failed, errno %d", errno));
+	    exit(1);
+	}
+    }
+    if (fd > biggest_fd) {
+	struct io_handler *handlers = realloc(input_handlers,
+	    sizeof(struct io_handler) * (fd + 1));
+
+	if (handlers == NULL) {
+	    plog(format("input handler %d realloc failed", fd));
+	    exit(1);
+	}
+	memset(handlers + biggest_fd + 1, 0,
+	    sizeof(struct io_handler) * (fd - biggest_fd));
+	input_handlers = handlers;
+	biggest_fd = fd;
+    }
+}
+
+/*
+ * Tell the kernel which events we want for "fd", given whether it is
+ * currently in the interest set.
+ */
+static int update_events(int fd, bool registered)
+{
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof(ev));
+    if (input_handlers[fd].func) ev.events |= EPOLLIN;
+    if (input_handlers[fd].out_func) ev.events |= EPOLLOUT;
+    ev.data.fd = fd;
+
+    if (!ev.events) {
+	return registered? epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, &ev): 0;
+    }
+    return epoll_ctl(epoll_fd, registered? EPOLL_CTL_MOD: EPOLL_CTL_ADD, fd, &ev);
+}
+
+void install_input(void (*func)(int, int), int fd, int arg)
+{
+    bool registered;
+
+    if (fd < 0) {
+	plog(format("install illegal input handler fd %d", fd));
+	exit(1);
+    }
+    grow_handlers(fd);
+    if (input_handlers[fd].func) {
+	plog(format("input handler %d busy", fd));
+	exit(1);
+    }
+    registered = (input_handlers[fd].out_func != NULL);
+    input_handlers[fd].func = func;
+    input_handlers[fd].arg = arg;
+    if (update_events(fd, registered) == -1) {
+	plog(format("epoll_ctl(%d) failed, errno %d", fd, errno));
+	exit(1);
+    }
+}
+
+/*
+ * Also drops the output handler, if any: the descriptor is usually about to
+ * be closed.
+ */
+void remove_input(int fd)
+{
+    struct epoll_event ev;
+
+    if ( fd < 0 ) {
+	plog(format("remove illegal input handler fd %d", fd));
+	exit(1);
+    }
+    if (fd <= biggest_fd && (input_handlers[fd].func || input_handlers[fd].out_func)) {
+	input_handlers[fd].func = 0;
+	input_handlers[fd].out_func = 0;
+
+	/*
+	 * Callers sometimes close the socket first, in which case the kernel
+	 * has already dropped it from the interest set and this fails with
+	 * EBADF. Either way the descriptor is gone.
+	 */
+	memset(&ev, 0, sizeof(ev));
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+    }
+}
+
+/*
+ * Ask to be called back when "fd" can accept more data.
+ */
+void install_output(void (*func)(int, int), int fd, int arg)
+{
+    bool registered;
+
+    if (fd < 0) {
+	plog(format("install illegal output handler fd %d", fd));
+	exit(1);
+    }
+    grow_handlers(fd);
+    if (input_handlers[fd].out_func == func && input_handlers[fd].out_arg == arg) {
+	return;
+    }
+    registered = (input_handlers[fd].func || input_handlers[fd].out_func);
+    input_handlers[fd].out_func = func;
+    input_handlers[fd].out_arg = arg;
+    if (update_events(fd, registered) == -1) {
+	plog(format("epoll_ctl(%d) failed, errno %d", fd, errno));
+	exit(1);
+    }
+}
+
+void remove_output(int fd)
+{
+    if (fd < 0 || fd > biggest_fd || !input_handlers[fd].out_func) {
+	return;
+    }
+    input_handlers[fd].out_func = 0;
+    if (update_events(fd, true) == -1) {
+	plog(format("epoll_ctl(%d) failed, errno %d", fd, errno));
+    }
+}
+
+/*
+ * Wait for input for at most "tvp" (forever if NULL) and dispatch it.
+ * Returns the number of ready descriptors, 0 on timeout, -1 on error.
+ */
+static int wait_for_input(struct timeval *tvp)
+{
+    int n, i;
+    int timeout = -1;
+
+    if (tvp) {
+	timeout = tvp->tv_sec * 1000 + (tvp->tv_usec + 999) / 1000;
+    }
+
+    n = epoll_wait(epoll_fd, epoll_events, MAX_EPOLL_EVENTS, timeout);
+    for (i = 0; i < n; i++) {
+	int fd = epoll_events[i].data.fd;
+	uint32_t events = epoll_events[i].events;
+
+	/* An earlier handler in this batch may have removed this descriptor */
+	if (fd > biggest_fd) {
+	    continue;
+	}
+	if (input_handlers[fd].func && (events & ~EPOLLOUT)) {
+	    (*input_handlers[fd].func)(fd, input_handlers[fd].arg);
+	}
+
+	/* The input handler may have closed the connection */
+	if (input_handlers[fd].out_func && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+	    (*input_handlers[fd].out_func)(fd, input_handlers[fd].out_arg);
+	}
+    }
+
+    return n;
+}
+
+#else
+
+#define NUM_SELECT_FD		(sizeof(int) * 8)
+
 /* donald sharp - I have modified this file such that it will */
 /* allow more than 32 file descriptors at once.  This is a good */
 /* thing and will allow future modifications to mangband */
@@ -333,6 +357,7 @@ struct io_handler {
 static struct io_handler *input_handlers = NULL;
 static int              biggest_fd = -1;
 static fd_set		input_mask;
+static fd_set		output_mask;
 static int              input_mask_cleared = FALSE;
 static int		max_fd;
 
@@ -341,22 +366,15 @@ static int		max_fd;
 static void clear_mask( void )
 {
     FD_ZERO(&input_mask);
+    FD_ZERO(&output_mask);
 }
 
-void install_input(void (*func)(int, int), int fd, int arg)
+static void grow_handlers(int fd)
 {
     if ( input_mask_cleared == FALSE ) {
        clear_mask();
        input_mask_cleared = TRUE;
     }
-    if (fd < 0 ) {
-	plog(format("install illegal input handler fd %d", fd));
-	exit(1);
-    }
-    if (FD_ISSET(fd,&input_mask)) {
-	plog(format("input handler %d busy", fd));
-	exit(1);
-    }
     if(input_handlers == NULL || fd > biggest_fd)
     {
         if( biggest_fd < fd )
@@ -371,34 +389,306 @@ void install_input(void (*func)(int, int), int fd, int arg)
            exit(1);
         }
     }
-    input_handlers[fd].func = func;
-    input_handlers[fd].arg = arg;
-    FD_SET(fd, &input_mask);
     if (fd >= max_fd) {
 	max_fd = fd + 1;
     }
 }
 
+/* Lower max_fd if "fd" was the highest descriptor we were watching */
+static void shrink_max_fd(int fd)
+{
+    if (fd == (max_fd - 1)) {
+	int i;
+	max_fd = 0;
+	for (i = fd; --i >= 0; ) {
+            if ( FD_ISSET( i, &input_mask ) || FD_ISSET( i, &output_mask ) ) {
+		max_fd = i + 1;
+		break;
+	    }
+	}
+    }
+}
+
+void install_input(void (*func)(int, int), int fd, int arg)
+{
+    if (fd < 0 ) {
+	plog(format("install illegal input handler fd %d", fd));
+	exit(1);
+    }
+    grow_handlers(fd);
+    if (FD_ISSET(fd,&input_mask)) {
+	plog(format("input handler %d busy", fd));
+	exit(1);
+    }
+    input_handlers[fd].func = func;
+    input_handlers[fd].arg = arg;
+    FD_SET(fd, &input_mask);
+}
+
+/*
+ * Also drops the output handler, if any: the descriptor is usually about to
+ * be closed.
+ */
 void remove_input(int fd)
 {
     if ( fd < 0 ) {
 	plog(format("remove illegal input handler fd %d", fd));
 	exit(1);
     }
-    if (FD_ISSET( fd, &input_mask )) {
+    if (FD_ISSET( fd, &input_mask ) || FD_ISSET( fd, &output_mask )) {
 	input_handlers[fd].func = 0;
         FD_CLR(fd, &input_mask);
-	if (fd == (max_fd - 1)) {
-	    int i;
-	    max_fd = 0;
-	    for (i = fd; --i >= 0; ) {
-                if ( FD_ISSET( i, &input_mask ) ) {
-		    max_fd = i + 1;
+        FD_CLR(fd, &output_mask);
+	shrink_max_fd(fd);
+    }
+}
+
+/*
+ * Ask to be called back when "fd" can accept more data.
+ */
+void install_output(void (*func)(int, int), int fd, int arg)
+{
+    if (fd < 0 ) {
+	plog(format("install illegal output handler fd %d", fd));
+	exit(1);
+    }
+    grow_handlers(fd);
+    input_handlers[fd].out_func = func;
+    input_handlers[fd].out_arg = arg;
+    FD_SET(fd, &output_mask);
+}
+
+void remove_output(int fd)
+{
+    if (fd >= 0 && FD_ISSET( fd, &output_mask )) {
+        FD_CLR(fd, &output_mask);
+	shrink_max_fd(fd);
+    }
+}
+
+/*
+ * Wait for input for at most "tvp" (forever if NULL) and dispatch it.
+ * Returns the number of ready descriptors, 0 on timeout, -1 on error.
+ */
+static int wait_for_input(struct timeval *tvp)
+{
+    int n;
+
+/*
+ * KLJ -- Prevent crashes caused by "input_mask" changing during
+ * the "timeout_chime" function call (which happens when a player 
+ * dies).
+ */
+    fd_set readmask = input_mask;
+    fd_set writemask = output_mask;
+
+    n = select(max_fd, &readmask, &writemask, 0, tvp);
+    if (n > 0) {
+	int i, left = n;
+	for (i = max_fd; i >= 0; i--) {
+            if (FD_ISSET(i,&readmask))  {
+		(*input_handlers[i].func)(i, input_handlers[i].arg);
+                readmask = input_mask; 
+		if (--left == 0) {
+		    break;
+		}
+	    }
+
+	    /* The input handler may have closed the connection */
+            if (FD_ISSET(i,&writemask) && FD_ISSET(i,&output_mask))  {
+		(*input_handlers[i].out_func)(i, input_handlers[i].out_arg);
+		if (--left == 0) {
 		    break;
 		}
 	    }
 	}
     }
+
+    return n;
+}
+
+#endif
+
+/*
+ * Frame pacing.
+ *
+ * Frames are scheduled on a fixed grid of CLOCK_MONOTONIC deadlines, so they
+ * neither drift with the time spent running each frame nor jump when the wall
+ * clock is changed. No signal is involved: the scheduler simply stops waiting
+ * for input when the next deadline is reached (on Linux a timerfd in the epoll
+ * set wakes it up, elsewhere the deadline becomes the select() timeout).
+ *
+ * A frame that starts more than half a period after its deadline is counted
+ * as late. When the server falls MAX_FRAME_CATCHUP or more frames behind, the
+ * frames it can't catch up on are dropped and counted instead of being run
+ * back to back. Both counts are logged once per minute if non-zero.
+ */
+#define NSEC_PER_SEC		1000000000LL
+#define MAX_FRAME_CATCHUP	2
+#define FRAME_REPORT_SECS	60
+
+struct frame_stats {
+    uint32_t		frames;		/* frames run */
+    uint32_t		late;		/* frames started late */
+    uint32_t		dropped;	/* frames skipped to catch up */
+    int64_t		total_lateness;	/* sum of start delays (ns) */
+    int64_t		max_lateness;	/* worst start delay (ns) */
+};
+
+static long		timer_freq;	/* rate at which frames are run */
+static void		(*timer_handler)(void);
+static int64_t		frame_period;	/* length of a frame (ns) */
+static int64_t		next_frame;	/* deadline of the next frame */
+static int64_t		next_chime;	/* deadline of the next timeout check */
+static int64_t		next_report;	/* deadline of the next stats report */
+static struct frame_stats frame_stats;
+#ifdef USE_EPOLL
+static int		frame_timer_fd = -1;
+#endif
+
+/*
+ * Read the monotonic clock, in nanoseconds.
+ */
+int64_t sched_clock(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+#ifdef USE_EPOLL
+/*
+ * The frame timer expired: just consume the expiration count, the scheduler
+ * checks the clock itself.
+ */
+static void frame_timer_ready(int fd, int arg)
+{
+    uint64_t expirations;
+
+    if (read(fd, &expirations, sizeof(expirations)) < 0) {
+	/* Nothing to do, we were woken up anyway */
+    }
+}
+#endif
+
+/*
+ * Setup the frame deadlines (and the timerfd that fires on them).
+ */
+static void setup_timer(void)
+{
+    int64_t now = sched_clock();
+
+    if (timer_freq <= 0) {
+	plog(format("illegal timer frequency: %ld", timer_freq));
+	exit(1);
+    }
+    frame_period = NSEC_PER_SEC / timer_freq;
+    next_frame = now + frame_period;
+    next_chime = now + NSEC_PER_SEC;
+    next_report = now + FRAME_REPORT_SECS * NSEC_PER_SEC;
+    memset(&frame_stats, 0, sizeof(frame_stats));
+    time(&current_time);
+
+#ifdef USE_EPOLL
+    {
+	struct itimerspec its;
+
+	if (frame_timer_fd == -1) {
+	    frame_timer_fd = timerfd_create(CLOCK_MONOTONIC,
+		TFD_NONBLOCK | TFD_CLOEXEC);
+	    if (frame_timer_fd == -1) {
+		plog(format("timerfd_create failed, errno %d", errno));
+		exit(1);
+	    }
+	    install_input(frame_timer_ready, frame_timer_fd, 0);
+	}
+
+	/* Fire on every frame deadline of the grid */
+	its.it_value.tv_sec = next_frame / NSEC_PER_SEC;
+	its.it_value.tv_nsec = next_frame % NSEC_PER_SEC;
+	its.it_interval.tv_sec = frame_period / NSEC_PER_SEC;
+	its.it_interval.tv_nsec = frame_period % NSEC_PER_SEC;
+	if (timerfd_settime(frame_timer_fd, TFD_TIMER_ABSTIME, &its, NULL) == -1) {
+	    plog(format("timerfd_settime failed, errno %d", errno));
+	    exit(1);
+	}
+    }
+#endif
+}
+
+/*
+ * Configure timer tick callback.
+ */
+void install_timer_tick(void (*func)(void), int freq)
+{
+    timer_handler = func;
+    timer_freq = freq;
+    setup_timer();
+}
+
+void remove_timer_tick(void)
+{
+    timer_handler = NULL;
+}
+
+/*
+ * Log the frame statistics gathered since the last report, if anything
+ * went wrong.
+ */
+static void report_frame_stats(void)
+{
+    if (frame_stats.late || frame_stats.dropped) {
+	plog_fmt("Frame pacer: %lu/%lu frames late (avg %ld us, max %ld us), %lu dropped",
+	    (unsigned long)frame_stats.late, (unsigned long)frame_stats.frames,
+	    (long)(frame_stats.total_lateness / frame_stats.frames / 1000),
+	    (long)(frame_stats.max_lateness / 1000),
+	    (unsigned long)frame_stats.dropped);
+    }
+    memset(&frame_stats, 0, sizeof(frame_stats));
+}
+
+/*
+ * Run the frame that was due at "next_frame" and schedule the following one.
+ */
+static void run_frame(int64_t now)
+{
+    int64_t lateness = now - next_frame;
+
+    frame_stats.frames++;
+    frame_stats.total_lateness += lateness;
+    if (lateness > frame_stats.max_lateness) {
+	frame_stats.max_lateness = lateness;
+    }
+    if (lateness > frame_period / 2) {
+	frame_stats.late++;
+    }
+
+    if (timer_handler) {
+	(*timer_handler)();
+    }
+
+    next_frame += frame_period;
+
+    /* Too far behind: drop the frames we can't catch up on */
+    now = sched_clock();
+    if (now - next_frame >= MAX_FRAME_CATCHUP * frame_period) {
+	int64_t missed = (now - next_frame) / frame_period;
+
+	frame_stats.dropped += (uint32_t)missed;
+	next_frame += missed * frame_period;
+    }
+
+    while (now >= next_chime) {
+	current_time++;
+	next_chime += NSEC_PER_SEC;
+	timeout_chime();
+    }
+
+    if (now >= next_report) {
+	report_frame_stats();
+	next_report = now + FRAME_REPORT_SECS * NSEC_PER_SEC;
+    }
 }
 
 static int		sched_running;
@@ -413,15 +703,7 @@ void stop_sched(void)
  */
 void sched(void)
 {
-    int			io_done = 0, io_todo = 3;
-    struct timeval	tv, *tvp = &tv;
-    fd_set              readmask;
-
-    readmask = input_mask;
-#ifdef VMS
-    extern int NumPlayers, NumRobots, NumPseudoPlayers, NumQueuedPlayers;
-    extern int login_in_progress;
-#endif
+    struct timeval	tv;
 
     if (sched_running) {
 	plog("sched already running");
@@ -430,90 +712,36 @@ void sched(void)
     sched_running = 1;
 
     while (sched_running) {
+	int64_t now = sched_clock();
+	int n;
 
-#ifdef VMS
-        if (NumPlayers > NumRobots + NumPseudoPlayers
-            || login_in_progress != 0
-            || NumQueuedPlayers > 0) {
-
-            /* need fast I/O checks now! (2 or 3 times per frames) */
-            tv.tv_sec = 0;
-            tv.tv_usec = 1000000 / (3 * timer_freq + 1); 
-        }
-        else {
-            /* slow I/O checks are possible here... (2 times per second) */ ; 
-            tv.tv_sec = 0;
-            tv.tv_usec = 500000;
-        }
-#else
-        tv.tv_sec = 0;
-        tv.tv_usec = 0;
-#endif
-
-	if (io_todo == 0 && timers_used < timer_ticks) {
-	    io_done = 0;
-	    io_todo = 3;
-	    tvp = &tv;
-
-	    if (timer_handler) {
-		(*timer_handler)();
-	    }
-
-	    do {
-		++timers_used;
-		if (--ticks_till_second <= 0) {
-		    ticks_till_second += timer_freq;
-		    current_time++;
-		    timeout_chime();
-		}
-	    } while (timers_used + 1 < timer_ticks);
+	if (now >= next_frame) {
+	    run_frame(now);
 
+	    /* Always give the sockets a look between two frames, even when lagging */
+	    tv.tv_sec = 0;
+	    tv.tv_usec = 0;
+	    n = wait_for_input(&tv);
 	}
 	else {
-            int n;
+#ifdef USE_EPOLL
+	    /* The frame timer is in the epoll set and will wake us up */
+	    n = wait_for_input(NULL);
+#else
+	    /* Round up to whole microseconds first, so tv_usec stays below one second */
+	    int64_t wait = (next_frame - now + 999) / 1000;
 
-/*
- * KLJ -- Prevent crashes caused by "input_mask" changing during
- * the "timeout_chime" function call (which happens when a player 
- * dies).
- */
-	    readmask = input_mask;
-
-	    n = select(max_fd, &readmask, 0, 0, tvp);
-	    if (n < 0) {
-		if (errno != EINTR) {
-                    plog(format("Errno: %d\n",errno));
-		    core("sched select error");
-		    exit(1);
-		}
-		io_todo = 0;
-	    }
-	    else if (n == 0) {
-                readmask = input_mask;
-		io_todo = 0;
-	    }
-	    else {
-		int i;
-		for (i = max_fd; i >= 0; i--) {
-                    if (FD_ISSET(i,&readmask))  {
-			(*input_handlers[i].func)(i, input_handlers[i].arg);
-                        readmask = input_mask; 
-			if (--n == 0) {
-			    break;
-			}
-		    }
-		}
-		io_done++;
-		if (io_todo > 0) {
-		    io_todo--;
-		}
-	    }
-#ifndef VMS
-	    if (io_todo == 0) {
-		tvp = NULL;
-	    }
+	    tv.tv_sec = wait / 1000000;
+	    tv.tv_usec = wait % 1000000;
+	    n = wait_for_input(&tv);
 #endif
 	}
+
+	if (n < 0 && errno != EINTR) {
+	    plog(format("Errno: %d\n",errno));
+	    core("sched select error");
+	    exit(1);
+	}
     }
 }
 
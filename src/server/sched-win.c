@@ -247,12 +247,15 @@ struct io_handler
 {
     void (*func)(int, int);
     int arg;
+    void (*out_func)(int, int); /* called when writable */
+    int out_arg;
 };
 
 
 static struct io_handler *input_handlers = NULL;
 static int biggest_fd = -1;
 static fd_set input_mask;
+static fd_set output_mask;
 static int input_mask_cleared = false;
 static int max_fd;
 
@@ -261,26 +264,17 @@ static int max_fd;
 static void clear_mask(void)
 {
     FD_ZERO(&input_mask);
+    FD_ZERO(&output_mask);
 }
 
 
-void install_input(void (*func)(int, int), int fd, int arg)
+static void grow_handlers(int fd)
 {
     if (input_mask_cleared == false)
     {
         clear_mask();
         input_mask_cleared = true;
     }
-    if (fd < 0)
-    {
-        plog_fmt("install illegal input handler fd %d", fd);
-        exit(1);
-    }
-    if (FD_ISSET(fd, &input_mask))
-    {
-        plog_fmt("input handler %d busy", fd);
-        exit(1);
-    }
     if ((input_handlers == NULL) || (fd > biggest_fd))
     {
         if (biggest_fd < fd)
@@ -295,13 +289,53 @@ void install_input(void (*func)(int, int), int fd, int arg)
             exit(1);
         }
     }
+    if (fd >= max_fd) max_fd = fd + 1;
+}
+
+
+/* Lower max_fd if "fd" was the highest descriptor we were watching */
+static void shrink_max_fd(int fd)
+{
+    if (fd == (max_fd - 1))
+    {
+        int i;
+
+        max_fd = 0;
+        for (i = fd; --i >= 0; )
+        {
+            if (FD_ISSET(i, &input_mask) || FD_ISSET(i, &output_mask))
+            {
+                max_fd = i + 1;
+                break;
+            }
+        }
+    }
+}
+
+
+void install_input(void (*func)(int, int), int fd, int arg)
+{
+    if (fd < 0)
+    {
+        plog_fmt("install illegal input handler fd %d", fd);
+        exit(1);
+    }
+    grow_handlers(fd);
+    if (FD_ISSET(fd, &input_mask))
+    {
+        plog_fmt("input handler %d busy", fd);
+        exit(1);
+    }
     input_handlers[fd].func = func;
     input_handlers[fd].arg = arg;
     FD_SET((SOCKET)fd, &input_mask);
-    if (fd >= max_fd) max_fd = fd + 1;
 }
 
 
+/*
+ * Also drops the output handler, if any: the descriptor is usually about to
+ * be closed.
+ */
 void remove_input(int fd)
 {
     if (fd < 0)
@@ -309,24 +343,39 @@ void remove_input(int fd)
         plog_fmt("remove illegal input handler fd %d", fd);
         exit(1);
     }
-    if (FD_ISSET(fd, &input_mask))
+    if (FD_ISSET(fd, &input_mask) || FD_ISSET(fd, &output_mask))
     {
         input_handlers[fd].func = 0;
         FD_CLR((SOCKET)fd, &input_mask);
-        if (fd == (max_fd - 1))
-        {
-            int i;
+        FD_CLR((SOCKET)fd, &output_mask);
+        shrink_max_fd(fd);
+    }
+}
 
-            max_fd = 0;
-            for (i = fd; --i >= 0; )
-            {
-                if (FD_ISSET(i, &input_mask))
-                {
-                    max_fd = i + 1;
-                    break;
-                }
-            }
-        }
+
+/*
+ * Ask to be called back when "fd" can accept more data.
+ */
+void install_output(void (*func)(int, int), int fd, int arg)
+{
+    if (fd < 0)
+    {
+        plog_fmt("install illegal output handler fd %d", fd);
+        exit(1);
+    }
+    grow_handlers(fd);
+    input_handlers[fd].out_func = func;
+    input_handlers[fd].out_arg = arg;
+    FD_SET((SOCKET)fd, &output_mask);
+}
+
+
+void remove_output(int fd)
+{
+    if ((fd >= 0) && FD_ISSET(fd, &output_mask))
+    {
+        FD_CLR((SOCKET)fd, &output_mask);
+        shrink_max_fd(fd);
     }
 }
 
@@ -346,6 +395,7 @@ void sched(void)
     int io_done = 0, io_todo = 3;
     struct timeval tv;
     fd_set readmask = input_mask;
+    fd_set writemask = output_mask;
 
     while (true)
     {
@@ -380,8 +430,9 @@ void sched(void)
              * the "timeout_chime" function call (which happens when a player dies).
              */
             readmask = input_mask;
+            writemask = output_mask;
 
-            n = select(max_fd, &readmask, NULL, NULL, &tv);
+            n = select(max_fd, &readmask, &writemask, NULL, &tv);
             if (n < 0)
             {
                 /* Don't report fake socket errors, or when already quitting */
@@ -406,6 +457,13 @@ void sched(void)
                         readmask = input_mask;
                         if (--n == 0) break;
                     }
+
+                    /* The input handler may have closed the connection */
+                    if (FD_ISSET(i, &writemask) && FD_ISSET(i, &output_mask))
+                    {
+                        (*input_handlers[i].out_func)(i, input_handlers[i].out_arg);
+                        if (--n == 0) break;
+                    }
                 }
                 io_done++;
                 if (io_todo > 0) io_todo--;
@@ -427,3 +485,19 @@ void remove_timer_tick(void)
     if (timer_id != 0) stop_timer();
     timer_handler = null_timer_handler;
 }
+
+
+/*
+ * Read the monotonic clock, in nanoseconds.
+ */
+int64_t sched_clock(void)
+{
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+
+    return (int64_t)(now.QuadPart / freq.QuadPart) * 1000000000LL +
+        (int64_t)(now.QuadPart % freq.QuadPart) * 1000000000LL / freq.QuadPart;
+}
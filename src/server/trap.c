@@ -107,6 +107,7 @@ bool square_remove_trap(struct chunk *c, struct loc *grid, struct trap *trap, bo
         {
             my_assert(loc_eq(grid, &trap->grid));
             removed = true;
+            c->modified = true;
             mem_free(trap);
             if (prev_trap)
                 prev_trap->next = next_trap;
@@ -185,6 +186,7 @@ bool square_remove_all_traps_of_type(struct chunk *c, struct loc *grid, unsigned
         {
             mem_free(trap);
             removed = true;
+            c->modified = true;
 
             if (prev_trap)
                 prev_trap->next = next_trap;
@@ -1624,6 +1624,7 @@ void init_wild_info(void)
             size = w_ptr->max_depth - w_ptr->min_depth + 1;
             w_ptr->chunk_list = mem_zalloc(size * sizeof(struct chunk *));
             w_ptr->players_on_depth = mem_zalloc(size * sizeof(int16_t));
+            w_ptr->on_disk = mem_zalloc(size * sizeof(bool));
 
             /* Type */
             w_ptr->type = WILD_UNDEFINED;
@@ -1670,8 +1671,10 @@ void free_wild_info(void)
 
             mem_free(w_ptr->chunk_list);
             mem_free(w_ptr->players_on_depth);
+            mem_free(w_ptr->on_disk);
         }
     }
+    chunk_list_free();
 
     for (i = 0; i <= 2 * radius_wild; i++)
         mem_free(wt_info[i]);
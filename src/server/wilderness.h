@@ -231,6 +231,7 @@ struct wild_type
 
     struct chunk **chunk_list;  /* List of pointers to saved chunks */
     int16_t *players_on_depth;     /* How many players are at each depth */
+    bool *on_disk;              /* Levels swapped out to their own savefile */
 
     int type;                   /* What kind of terrain we are in (transient) */
     int distance;               /* Distance from towns (transient) */